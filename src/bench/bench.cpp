@@ -0,0 +1,794 @@
+#include <string>
+#include <vector>
+#include <chrono>
+#include <ctime>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "../utils/vecmath.h"
+#include "../entities/boid.h"
+
+/************************************************************************************************************
+* Times every stage of a simulation tick on its own and writes the results as JSON:
+* neighbor-list refresh, grid build, reordering, neighbor gathering, steering, integration and draw-list preparation.
+* The stages run on one thread unless --threads asks for more, so by default the numbers do not depend on
+* the machine's core count.
+*************************************************************************************************************/
+
+enum class Distribution
+{
+	Uniform,
+	Clustered,
+	SingleSchool,
+	// every group is a school of its own
+	Schools
+};
+
+const char* distributionName(Distribution distribution)
+{
+	switch (distribution)
+	{
+	case Distribution::Uniform:
+		return "uniform";
+	case Distribution::Clustered:
+		return "clustered";
+	case Distribution::SingleSchool:
+		return "single-school";
+	case Distribution::Schools:
+		return "schools";
+	}
+
+	return "";
+}
+
+const char* cellOrderName(CellOrder order)
+{
+	switch (order)
+	{
+	case CellOrder::RowMajor:
+		return "row";
+	case CellOrder::Morton:
+		return "morton";
+	case CellOrder::Hilbert:
+		return "hilbert";
+	}
+
+	return "";
+}
+
+struct BenchOptions
+{
+	BenchOptions();
+
+	std::vector<size_t> sizes;
+	std::vector<Distribution> distributions;
+	size_t groups;
+	size_t threads;
+	size_t reps;
+	float dt;
+	float areaPerBoid;
+	CellOrder cellOrder;
+	bool reorder;
+	float skin;
+	bool pairwise;
+	bool meanField;
+	float meanFieldError;
+	SimdLevel simdLevel;
+	bool fastReciprocal;
+	size_t nearest;
+	bool isolated;
+	// given to the groups in turn
+	std::vector<float> viewDistances;
+	unsigned int seed;
+	std::string output;
+};
+
+BenchOptions::BenchOptions()
+{
+	sizes = { 1000, 10000, 100000, 1000000 };
+	distributions = { Distribution::Uniform, Distribution::Clustered, Distribution::SingleSchool };
+	groups = 3;
+	threads = 1;
+	reps = 5;
+	dt = 1.0f / 60.0f;
+	// 650 boids on a 1080x720 window, what main.cpp starts with
+	areaPerBoid = 1200.0f;
+	cellOrder = CellOrder::RowMajor;
+	reorder = false;
+	skin = 0.0f;
+	pairwise = false;
+	meanField = false;
+	meanFieldError = 0.5f;
+	simdLevel = detectSimdLevel();
+	fastReciprocal = false;
+	nearest = 0;
+	isolated = false;
+	viewDistances = { 60.0f };
+	seed = 1;
+}
+
+/************************************************************************************************************
+* Timings of one stage over all repetitions.
+*************************************************************************************************************/
+struct StageTimer
+{
+	StageTimer();
+
+	void add(double seconds);
+
+	double total;
+	double min;
+	double max;
+	size_t samples;
+};
+
+StageTimer::StageTimer()
+{
+	total = 0.0;
+	min = 0.0;
+	max = 0.0;
+	samples = 0;
+}
+
+void StageTimer::add(double seconds)
+{
+	min = samples ? std::min(min, seconds) : seconds;
+	max = samples ? std::max(max, seconds) : seconds;
+	total += seconds;
+	samples++;
+}
+
+struct BenchResult
+{
+	Distribution distribution;
+	size_t boids;
+	size_t groups;
+	Vec2f size;
+	double neighborsPerBoid;
+	size_t neighborRebuilds;
+	// RMS of the velocity error after one mean-field tick, relative to the RMS velocity of the exact tick
+	double meanFieldError;
+
+	StageTimer neighborRefresh;
+	StageTimer gridBuild;
+	StageTimer reorder;
+	StageTimer neighborSearch;
+	StageTimer steering;
+	StageTimer integration;
+	StageTimer drawPreparation;
+};
+
+typedef std::chrono::steady_clock Clock;
+
+double secondsSince(Clock::time_point start)
+{
+	return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+float rand_normal()
+{
+	// Box-Muller, rand_float can return 0 so keep the logarithm finite
+	float u = std::max(rand_float(), 1e-7f);
+	float v = rand_float();
+
+	return std::sqrt(-2.0f * std::log(u)) * std::cos(2.0f * static_cast<float>(M_PI) * v);
+}
+
+void placeBoids(BoidSystem& boidSystem, Distribution distribution)
+{
+	const Boundary2f& bounds = *boidSystem.getBoidBoundary();
+	Vec2f size = bounds.getSize();
+	std::vector<BoidGroup>& groups = boidSystem.getGroups();
+
+	// clusters are a tenth of the boundary across, the single school a fifth
+	const size_t clusterCount = 8;
+	std::vector<Vec2f> centers(clusterCount);
+	for (size_t i = 0; i < clusterCount; i++)
+	{
+		centers[i] = Vec2f(rand_float(0.1f, 0.9f) * size.x, rand_float(0.1f, 0.9f) * size.y) + bounds.min;
+	}
+	Vec2f clusterSpread = size * 0.05f;
+	Vec2f schoolSpread = size * 0.1f;
+	Vec2f schoolCenter = bounds.min + size * 0.5f;
+
+	for (size_t i = 0; i < groups.size(); i++)
+	{
+		BoidArray& boids = groups[i].getBoids();
+		float maxSpeed = *groups[i].getBoidMaxSpeed();
+		Vec2f heading = rand_direction();
+
+		// as dense as the single school
+		if (distribution == Distribution::Schools)
+		{
+			schoolCenter = Vec2f(rand_float(0.1f, 0.9f) * size.x, rand_float(0.1f, 0.9f) * size.y) + bounds.min;
+			schoolSpread = size * (0.1f / std::sqrt(static_cast<float>(groups.size())));
+		}
+
+		for (size_t j = 0; j < boids.size(); j++)
+		{
+			Vec2f position;
+			Vec2f velocity;
+
+			switch (distribution)
+			{
+			case Distribution::Uniform:
+				position = bounds.min + Vec2f(rand_float() * size.x, rand_float() * size.y);
+				velocity = rand_direction() * (rand_float(0.5f, 1.0f) * maxSpeed);
+				break;
+
+			case Distribution::Clustered:
+			{
+				const Vec2f& center = centers[rand_int(0, static_cast<int>(clusterCount) - 1)];
+				position = center + Vec2f(rand_normal() * clusterSpread.x, rand_normal() * clusterSpread.y);
+				velocity = rand_direction() * (rand_float(0.5f, 1.0f) * maxSpeed);
+				break;
+			}
+
+			case Distribution::SingleSchool:
+			case Distribution::Schools:
+				position = schoolCenter + Vec2f(rand_normal() * schoolSpread.x, rand_normal() * schoolSpread.y);
+				velocity = Vec2f::normalize(heading + rand_direction() * 0.2f) * (rand_float(0.5f, 1.0f) * maxSpeed);
+				break;
+			}
+
+			boids.setPosition(j, position);
+			boids.setVelocity(j, velocity);
+		}
+
+		groups[i].updateSummary();
+	}
+}
+
+// the same boids for the same options and run, whatever the system
+void setupBench(BoidSystem& boidSystem, const BenchOptions& options, const BenchResult& result)
+{
+	srand(options.seed);
+
+	Boundary2f bounds(Vec2f(0.0f, 0.0f), result.size);
+	Vec2f boundaryRepel(15.0f, 15.0f);
+	boidSystem.setBoidBoundary(bounds);
+	boidSystem.setBoidBoundaryRepel(boundaryRepel);
+	boidSystem.setThreadCount(options.threads);
+	boidSystem.setCellOrder(options.cellOrder);
+	boidSystem.setReordering(options.reorder);
+	boidSystem.setNeighborSkin(options.skin);
+	boidSystem.setPairwise(options.pairwise);
+	boidSystem.setSimdLevel(options.simdLevel);
+	boidSystem.setFastReciprocal(options.fastReciprocal);
+
+	for (size_t i = 0; i < result.groups; i++)
+	{
+		size_t count = result.boids / result.groups + (i < result.boids % result.groups ? 1 : 0);
+
+		BoidGroup& boidGroup = *boidSystem.addGroup(count);
+		boidGroup.setBoidSize(Vec2f(15.0f, 5.0f));
+		boidGroup.setBoidFriendliness(0.1f);
+		boidGroup.setBoidViewDistance(options.viewDistances[i % options.viewDistances.size()]);
+		boidGroup.setBoidMinSeparationDistance(15.0f);
+		boidGroup.setBoidMaxSpeed(100.0f);
+		boidGroup.setNearestCount(options.nearest);
+	}
+
+	if (options.isolated)
+	{
+		for (size_t i = 0; i < result.groups; i++)
+		{
+			for (size_t j = 0; j < result.groups; j++)
+			{
+				if (i != j)
+				{
+					boidSystem.setInteraction(i, j, GroupInteraction(0.0f, 0.0f, 0.0f));
+				}
+			}
+		}
+	}
+
+	placeBoids(boidSystem, result.distribution);
+}
+
+double measureMeanFieldError(const BenchOptions& options, const BenchResult& result)
+{
+	BoidSystem exactSystem;
+	BoidSystem meanFieldSystem;
+	setupBench(exactSystem, options, result);
+	setupBench(meanFieldSystem, options, result);
+	meanFieldSystem.setMeanField(true);
+	meanFieldSystem.setMeanFieldError(options.meanFieldError);
+
+	exactSystem.update(options.dt);
+	meanFieldSystem.update(options.dt);
+
+	double error2 = 0.0;
+	double velocity2 = 0.0;
+
+	for (size_t i = 0; i < result.groups; i++)
+	{
+		const BoidArray& exact = exactSystem.getGroup(i).getBoids();
+		const BoidArray& meanField = meanFieldSystem.getGroup(i).getBoids();
+
+		for (size_t j = 0; j < exact.size(); j++)
+		{
+			double dx = meanField.getVX()[j] - exact.getVX()[j];
+			double dy = meanField.getVY()[j] - exact.getVY()[j];
+
+			error2 += dx * dx + dy * dy;
+			velocity2 += static_cast<double>(exact.getVX()[j]) * exact.getVX()[j] + static_cast<double>(exact.getVY()[j]) * exact.getVY()[j];
+		}
+	}
+
+	return velocity2 > 0.0 ? std::sqrt(error2 / velocity2) : 0.0;
+}
+
+BenchResult runBench(const BenchOptions& options, Distribution distribution, size_t boidCount)
+{
+	BenchResult result;
+	result.distribution = distribution;
+	result.boids = boidCount;
+	result.groups = distribution == Distribution::SingleSchool ? 1 : options.groups;
+	result.neighborsPerBoid = 0.0;
+	result.meanFieldError = 0.0;
+
+	// keep the density of the default scene at every size, 3:2 like the window
+	float area = options.areaPerBoid * static_cast<float>(boidCount);
+	result.size = Vec2f(std::sqrt(area * 1.5f), std::sqrt(area / 1.5f));
+
+	BoidSystem boidSystem;
+	setupBench(boidSystem, options, result);
+
+	if (options.meanField)
+	{
+		result.meanFieldError = measureMeanFieldError(options, result);
+		boidSystem.setMeanField(true);
+		boidSystem.setMeanFieldError(options.meanFieldError);
+	}
+
+	std::vector<BoidInstance> instances;
+	size_t neighborCount = 0;
+	result.neighborRebuilds = 0;
+
+	// the first tick only warms up the allocations of the grid and the neighbor table
+	for (size_t rep = 0; rep <= options.reps; rep++)
+	{
+		// a tick that keeps its neighbor lists spends nothing on the three stages after the refresh
+		Clock::time_point start = Clock::now();
+		bool refreshed = boidSystem.refreshNeighbors();
+		double refreshSeconds = secondsSince(start);
+
+		double gridSeconds = 0.0;
+		double reorderSeconds = 0.0;
+		double neighborSeconds = 0.0;
+
+		if (!refreshed)
+		{
+			start = Clock::now();
+			boidSystem.rebuildGrid();
+			gridSeconds = secondsSince(start);
+
+			start = Clock::now();
+			if (options.reorder)
+			{
+				boidSystem.reorderBoids();
+			}
+			reorderSeconds = secondsSince(start);
+
+			start = Clock::now();
+			boidSystem.findNeighbors();
+			neighborSeconds = secondsSince(start);
+		}
+
+		// the pair sums are gathered every tick, kept neighbor lists or not
+		if (options.meanField)
+		{
+			start = Clock::now();
+			boidSystem.accumulateMeanField();
+			neighborSeconds += secondsSince(start);
+		}
+		else if (options.pairwise)
+		{
+			start = Clock::now();
+			boidSystem.accumulatePairs();
+			neighborSeconds += secondsSince(start);
+		}
+
+		start = Clock::now();
+		boidSystem.steer();
+		double steeringSeconds = secondsSince(start);
+
+		start = Clock::now();
+		boidSystem.integrate(options.dt);
+		boidSystem.swapBuffers();
+		double integrationSeconds = secondsSince(start);
+
+		start = Clock::now();
+		// halfway between two ticks, like a window drawing faster than it simulates
+		boidSystem.prepareInstances(instances, 0.5f);
+		double drawSeconds = secondsSince(start);
+
+		neighborCount = boidSystem.getNeighborCount();
+
+		if (rep)
+		{
+			result.neighborRebuilds += refreshed ? 0 : 1;
+			result.neighborRefresh.add(refreshSeconds);
+			result.gridBuild.add(gridSeconds);
+			result.reorder.add(reorderSeconds);
+			result.neighborSearch.add(neighborSeconds);
+			result.steering.add(steeringSeconds);
+			result.integration.add(integrationSeconds);
+			result.drawPreparation.add(drawSeconds);
+		}
+	}
+
+	result.neighborsPerBoid = boidCount ? static_cast<double>(neighborCount) / boidCount : 0.0;
+
+	return result;
+}
+
+void writeStage(std::ostream& out, const char* name, const StageTimer& timer, size_t boids, bool last)
+{
+	double mean = timer.samples ? timer.total / timer.samples : 0.0;
+	double nsPerBoid = boids ? mean * 1e9 / boids : 0.0;
+
+	out << "        \"" << name << "\": { "
+		<< "\"mean_ms\": " << to_stringn(mean * 1e3, 4) << ", "
+		<< "\"min_ms\": " << to_stringn(timer.min * 1e3, 4) << ", "
+		<< "\"max_ms\": " << to_stringn(timer.max * 1e3, 4) << ", "
+		<< "\"ns_per_boid\": " << to_stringn(nsPerBoid, 2) << " }"
+		<< (last ? "\n" : ",\n");
+}
+
+void writeJson(std::ostream& out, const BenchOptions& options, const std::vector<BenchResult>& results)
+{
+	out << "{\n"
+		<< "  \"benchmark\": \"SchoolsOfFishBench\",\n"
+		<< "  \"threads\": " << options.threads << ",\n"
+		<< "  \"reps\": " << options.reps << ",\n"
+		<< "  \"dt\": " << to_stringn(options.dt, 6) << ",\n"
+		<< "  \"area_per_boid\": " << to_stringn(options.areaPerBoid, 2) << ",\n"
+		<< "  \"cell_order\": \"" << cellOrderName(options.cellOrder) << "\",\n"
+		<< "  \"reorder\": " << (options.reorder ? "true" : "false") << ",\n"
+		<< "  \"nearest\": " << options.nearest << ",\n"
+		<< "  \"isolated\": " << (options.isolated ? "true" : "false") << ",\n"
+		<< "  \"view_distances\": [";
+
+	for (size_t i = 0; i < options.viewDistances.size(); i++)
+	{
+		out << (i ? ", " : "") << to_stringn(options.viewDistances[i], 2);
+	}
+
+	out << "],\n"
+		<< "  \"pairwise\": " << (options.pairwise ? "true" : "false") << ",\n"
+		<< "  \"skin\": " << to_stringn(options.skin, 2) << ",\n"
+		<< "  \"mean_field\": " << (options.meanField ? to_stringn(options.meanFieldError, 2) : "false") << ",\n"
+		<< "  \"simd\": \"" << simdLevelName(std::min(options.simdLevel, detectSimdLevel())) << "\",\n"
+		<< "  \"fast_reciprocal\": " << (options.fastReciprocal ? "true" : "false") << ",\n"
+		<< "  \"seed\": " << options.seed << ",\n"
+		<< "  \"results\": [\n";
+
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const BenchResult& result = results[i];
+
+		out << "    {\n"
+			<< "      \"distribution\": \"" << distributionName(result.distribution) << "\",\n"
+			<< "      \"boids\": " << result.boids << ",\n"
+			<< "      \"groups\": " << result.groups << ",\n"
+			<< "      \"width\": " << to_stringn(result.size.x, 1) << ",\n"
+			<< "      \"height\": " << to_stringn(result.size.y, 1) << ",\n"
+			<< "      \"neighbors_per_boid\": " << to_stringn(result.neighborsPerBoid, 2) << ",\n"
+			<< "      \"neighbor_rebuilds\": " << result.neighborRebuilds << ",\n"
+			<< "      \"mean_field_error\": " << to_stringn(result.meanFieldError, 6) << ",\n"
+			<< "      \"stages\": {\n";
+
+		writeStage(out, "neighbor_refresh", result.neighborRefresh, result.boids, false);
+		writeStage(out, "grid_build", result.gridBuild, result.boids, false);
+		writeStage(out, "reorder", result.reorder, result.boids, false);
+		writeStage(out, "neighbor_search", result.neighborSearch, result.boids, false);
+		writeStage(out, "steering", result.steering, result.boids, false);
+		writeStage(out, "integration", result.integration, result.boids, false);
+		writeStage(out, "draw_preparation", result.drawPreparation, result.boids, true);
+
+		out << "      }\n"
+			<< "    }" << (i + 1 < results.size() ? ",\n" : "\n");
+	}
+
+	out << "  ]\n"
+		<< "}\n";
+}
+
+void printUsage(const char* program)
+{
+	std::cerr << "usage: " << program << " [options]\n"
+		<< "  --sizes N,N,...        boid counts (default 1000,10000,100000,1000000)\n"
+		<< "  --distributions D,...  uniform, clustered, single-school, schools (default: all but schools)\n"
+		<< "  --groups N             groups of the runs other than single-school, at most " << MAX_GROUPS << " (default 3)\n"
+		<< "  --threads N            worker threads (default 1)\n"
+		<< "  --reps N               timed ticks per run (default 5)\n"
+		<< "  --dt S                 seconds per tick (default 1/60)\n"
+		<< "  --area A               boundary area per boid (default 1200)\n"
+		<< "  --order O              cell order of the grid: row, morton or hilbert (default row)\n"
+		<< "  --reorder 0|1          sort the boids into cell order every tick (default 0)\n"
+		<< "  --nearest K            steer by the K nearest boids instead of the view distance (default 0: view distance)\n"
+		<< "  --isolated 0|1         groups ignore each other, zero weights between every pair (default 0)\n"
+		<< "  --view-distances D,... view distances, given to the groups in turn (default 60)\n"
+		<< "  --pairs 0|1            visit every pair of boids once and steer both (default 0)\n"
+		<< "  --skin D               keep the neighbor lists until a boid moves D/2 (default 0)\n"
+		<< "  --mean-field T         add cells of size <= T * distance as their aggregates (default: exact)\n"
+		<< "  --simd S               scalar, sse2, avx2 or avx512, capped at what the processor has (default: best)\n"
+		<< "  --fast-rcp 0|1         estimate the separation reciprocal in the SIMD steering kernels (default 0)\n"
+		<< "  --seed N               random seed (default 1)\n"
+		<< "  --out FILE             write the JSON to FILE instead of stdout\n";
+}
+
+bool parseSizes(const std::string& value, std::vector<size_t>& sizes)
+{
+	std::istringstream in(value);
+	std::string item;
+
+	sizes.clear();
+	while (std::getline(in, item, ','))
+	{
+		size_t size = std::strtoul(item.c_str(), nullptr, 10);
+		if (!size)
+		{
+			std::cerr << "invalid size " << item << "\n";
+			return false;
+		}
+
+		sizes.push_back(size);
+	}
+
+	return !sizes.empty();
+}
+
+bool parseDistributions(const std::string& value, std::vector<Distribution>& distributions)
+{
+	std::istringstream in(value);
+	std::string item;
+
+	distributions.clear();
+	while (std::getline(in, item, ','))
+	{
+		if (item == "uniform")
+		{
+			distributions.push_back(Distribution::Uniform);
+		}
+		else if (item == "clustered")
+		{
+			distributions.push_back(Distribution::Clustered);
+		}
+		else if (item == "single-school")
+		{
+			distributions.push_back(Distribution::SingleSchool);
+		}
+		else if (item == "schools")
+		{
+			distributions.push_back(Distribution::Schools);
+		}
+		else
+		{
+			std::cerr << "unknown distribution " << item << "\n";
+			return false;
+		}
+	}
+
+	return !distributions.empty();
+}
+
+bool parseViewDistances(const std::string& value, std::vector<float>& viewDistances)
+{
+	std::istringstream in(value);
+	std::string item;
+
+	viewDistances.clear();
+	while (std::getline(in, item, ','))
+	{
+		float viewDistance = std::strtof(item.c_str(), nullptr);
+		if (!(viewDistance > 0.0f))
+		{
+			std::cerr << "invalid view distance " << item << "\n";
+			return false;
+		}
+
+		viewDistances.push_back(viewDistance);
+	}
+
+	return !viewDistances.empty();
+}
+
+bool parseCellOrder(const std::string& value, CellOrder& order)
+{
+	if (value == "row")
+	{
+		order = CellOrder::RowMajor;
+	}
+	else if (value == "morton")
+	{
+		order = CellOrder::Morton;
+	}
+	else if (value == "hilbert")
+	{
+		order = CellOrder::Hilbert;
+	}
+	else
+	{
+		std::cerr << "unknown cell order " << value << "\n";
+		return false;
+	}
+
+	return true;
+}
+
+bool parseOptions(int argc, char** argv, BenchOptions& options)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+
+		if (arg == "--help" || arg == "-h")
+		{
+			return false;
+		}
+
+		if (i + 1 >= argc)
+		{
+			std::cerr << "missing value for " << arg << "\n";
+			return false;
+		}
+
+		const char* value = argv[++i];
+
+		if (arg == "--sizes")
+		{
+			if (!parseSizes(value, options.sizes))
+			{
+				return false;
+			}
+		}
+		else if (arg == "--distributions")
+		{
+			if (!parseDistributions(value, options.distributions))
+			{
+				return false;
+			}
+		}
+		else if (arg == "--groups")
+		{
+			options.groups = std::max<size_t>(std::strtoul(value, nullptr, 10), 1);
+
+			if (options.groups > MAX_GROUPS)
+			{
+				std::cerr << "at most " << MAX_GROUPS << " groups\n";
+				return false;
+			}
+		}
+		else if (arg == "--threads")
+		{
+			options.threads = std::max<size_t>(std::strtoul(value, nullptr, 10), 1);
+		}
+		else if (arg == "--reps")
+		{
+			options.reps = std::max<size_t>(std::strtoul(value, nullptr, 10), 1);
+		}
+		else if (arg == "--dt")
+		{
+			options.dt = std::strtof(value, nullptr);
+		}
+		else if (arg == "--area")
+		{
+			options.areaPerBoid = std::strtof(value, nullptr);
+		}
+		else if (arg == "--order")
+		{
+			if (!parseCellOrder(value, options.cellOrder))
+			{
+				return false;
+			}
+		}
+		else if (arg == "--reorder")
+		{
+			options.reorder = std::strtoul(value, nullptr, 10) != 0;
+		}
+		else if (arg == "--nearest")
+		{
+			options.nearest = std::strtoul(value, nullptr, 10);
+		}
+		else if (arg == "--isolated")
+		{
+			options.isolated = std::strtoul(value, nullptr, 10) != 0;
+		}
+		else if (arg == "--view-distances")
+		{
+			if (!parseViewDistances(value, options.viewDistances))
+			{
+				return false;
+			}
+		}
+		else if (arg == "--pairs")
+		{
+			options.pairwise = std::strtoul(value, nullptr, 10) != 0;
+		}
+		else if (arg == "--skin")
+		{
+			options.skin = std::strtof(value, nullptr);
+		}
+		else if (arg == "--mean-field")
+		{
+			options.meanField = true;
+			options.meanFieldError = std::strtof(value, nullptr);
+		}
+		else if (arg == "--simd")
+		{
+			if (!parseSimdLevel(value, options.simdLevel))
+			{
+				std::cerr << "unknown instruction set " << value << "\n";
+				return false;
+			}
+		}
+		else if (arg == "--fast-rcp")
+		{
+			options.fastReciprocal = std::strtoul(value, nullptr, 10) != 0;
+		}
+		else if (arg == "--seed")
+		{
+			options.seed = static_cast<unsigned int>(std::strtoul(value, nullptr, 10));
+		}
+		else if (arg == "--out")
+		{
+			options.output = value;
+		}
+		else
+		{
+			std::cerr << "unknown option " << arg << "\n";
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	BenchOptions options;
+
+	if (!parseOptions(argc, argv, options))
+	{
+		printUsage(argv[0]);
+		return 1;
+	}
+
+	std::vector<BenchResult> results;
+
+	for (size_t i = 0; i < options.distributions.size(); i++)
+	{
+		for (size_t j = 0; j < options.sizes.size(); j++)
+		{
+			// progress goes to stderr so stdout stays valid JSON
+			std::cerr << distributionName(options.distributions[i]) << " " << options.sizes[j] << "\n";
+
+			results.push_back(runBench(options, options.distributions[i], options.sizes[j]));
+		}
+	}
+
+	if (options.output.empty())
+	{
+		writeJson(std::cout, options, results);
+	}
+	else
+	{
+		std::ofstream out(options.output);
+		if (!out)
+		{
+			std::cerr << "cannot open " << options.output << "\n";
+			return 1;
+		}
+
+		writeJson(out, options, results);
+	}
+
+	return 0;
+}
@@ -1,5 +1,45 @@
 #include "boid.h"
 #include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+static Boundary2f emptyBounds()
+{
+	float max = std::numeric_limits<float>::max();
+
+	return Boundary2f(Vec2f(max, max), Vec2f(-max, -max));
+}
+
+// replaces the root of a max-heap and sifts it down, cheaper than pop_heap followed by push_heap
+static void replaceFarthest(std::vector<std::pair<float, uint32_t>>& heap, const std::pair<float, uint32_t>& candidate)
+{
+	size_t size = heap.size();
+	size_t i = 0;
+
+	for (;;)
+	{
+		size_t child = 2 * i + 1;
+
+		if (child >= size)
+		{
+			break;
+		}
+		if (child + 1 < size && heap[child] < heap[child + 1])
+		{
+			child++;
+		}
+		if (!(candidate < heap[child]))
+		{
+			break;
+		}
+
+		heap[i] = heap[child];
+		i = child;
+	}
+
+	heap[i] = candidate;
+}
 
 /************************************************************************************************************
 *												Boid
@@ -35,63 +75,49 @@ void Boid::setVelocity(const Vec2f& v)
 	m_Velocity = v;
 }
 
-void Boid::cohere(float cohesion, const std::vector<Boid*>& nearBoids, float friendliness)
+void Boid::steer(float cohesion, float separation, float alignment, float minSeparationDistance,
+	const SpatialGrid& grid, const NeighborSpan& friendlyBoids, const NeighborSpan& strangerBoids,
+	const float* viewDistances2, const GroupInteraction* weights, const GroupInteraction* strangerInteractions,
+	const KernelOptions& options)
 {
-	if (nearBoids.empty())
-	{
-		return;
-	}
-
-	Vec2f averagePosition(0.0f, 0.0f);
-
-	for (size_t i = 0; i < nearBoids.size(); i++)
-	{
-		averagePosition = averagePosition + nearBoids[i]->getPosition();
-	}
-
-	averagePosition = averagePosition / static_cast<float>(nearBoids.size());
-	Vec2f cohDir = averagePosition - m_Position;
-
-	m_Velocity = m_Velocity + cohDir * cohesion * friendliness;
-}
+	SteeringSums sums[2];
 
-void Boid::separate(float separation, float minSeparationDistance, const std::vector<Boid*>& nearBoids, float friendliness)
-{
-	if (nearBoids.empty())
+	sums[0].accumulate(options, m_Position, minSeparationDistance, grid, friendlyBoids, viewDistances2);
+	if (strangerInteractions)
 	{
-		return;
+		sums[1].accumulate(m_Position, minSeparationDistance, grid, strangerBoids, viewDistances2, strangerInteractions);
 	}
-
-	Vec2f sepDir(0.0f, 0.0f);
-
-	for (size_t i = 0; i < nearBoids.size(); i++)
+	else
 	{
-		Vec2f v = m_Position - nearBoids[i]->getPosition();
-
-		sepDir = sepDir + v / (Vec2f::length2(v) / (minSeparationDistance * minSeparationDistance));
+		sums[1].accumulate(options, m_Position, minSeparationDistance, grid, strangerBoids, viewDistances2);
 	}
 
-	m_Velocity = m_Velocity + sepDir * separation * std::min(1.0f / (friendliness + 0.000001f), 2.0f);
+	steer(cohesion, separation, alignment, sums, weights);
 }
 
-void Boid::align(float alignment, const std::vector<Boid*>& nearBoids, float friendliness)
+void Boid::steer(float cohesion, float separation, float alignment, const SteeringSums* sums, const GroupInteraction* weights)
 {
-	if (nearBoids.empty())
+	Vec2f steering(0.0f, 0.0f);
+
+	for (size_t i = 0; i < 2; i++)
 	{
-		return;
-	}
+		if (!sums[i].count)
+		{
+			continue;
+		}
 
-	Vec2f aliDir(0.0f, 0.0f);
+		float count = static_cast<float>(sums[i].count);
+		Vec2f positionSum(sums[i].positionX, sums[i].positionY);
+		Vec2f cohDir = sums[i].weighted ? (positionSum - m_Position * sums[i].cohesionWeight) / count : positionSum / count - m_Position;
+		Vec2f sepDir(sums[i].separationX, sums[i].separationY);
+		Vec2f aliDir = Vec2f(sums[i].velocityX, sums[i].velocityY) / count;
 
-	for (size_t i = 0; i < nearBoids.size(); i++)
-	{
-		aliDir = aliDir + nearBoids[i]->getVelocity();
+		steering += cohDir * cohesion * weights[i].cohesion;
+		steering += sepDir * separation * weights[i].separation;
+		steering += aliDir * alignment * weights[i].alignment;
 	}
-	
-	aliDir = aliDir / static_cast<float>(nearBoids.size());
-	Vec2f v = aliDir - m_Velocity;
 
-	m_Velocity = m_Velocity + aliDir * alignment * friendliness;
+	m_Velocity += steering;
 }
 
 void Boid::constrainBounds(const Boundary2f& bounds, const Vec2f& boundaryRepel)
@@ -125,422 +151,2289 @@ void Boid::constrainSpeed(float maxSpeed)
 
 void Boid::update(float dt)
 {
-	m_Position = m_Position + m_Velocity * dt;
-}
-
-void Boid::draw(GLuint modelList, const Vec2f& size, const Vec4f& color) const
-{
-	glMatrixMode(GL_MODELVIEW);
-	glPushMatrix();
-
-	glTranslatef(m_Position.x, m_Position.y, 0.0f);
-	glRotatef(getAngle(), 0.0f, 0.0f, -1.0f);
-	glScalef(size.x, size.y, 1.0f);
-	glColorVec4f(color);
-
-	glCallList(modelList);
-
-	glPopMatrix();
+	m_Position += m_Velocity * dt;
 }
 
 /************************************************************************************************************
-*											BoidGroup
+*											GroupInteraction
 *************************************************************************************************************/
 
-GLuint BoidGroup::m_ModelList = 0;
-
-BoidGroup::BoidGroup()
+GroupInteraction::GroupInteraction()
 {
-	m_Size = Vec2f(1.0f, 1.0f);
-
-	m_Cohesion = 0.2f;
-	m_Separation = 0.5f;
-	m_Alignment = 0.3f;
-	m_Friendliness = 0.2f;
-
-	m_ViewDistance = 10.0f;
-	m_MinSeparationDistance = 40.0f;
-	m_MaxSpeed = 60.0f;
-
-	m_Color = Vec4f(0.1f, 0.8f, 0.3f);
-
-	setCount(30, Boundary2f(Vec2f(0.0f, 0.0f), Vec2f(800.0f, 600.0f)));
+	cohesion = 1.0f;
+	alignment = 1.0f;
+	separation = 1.0f;
 }
 
-BoidGroup::BoidGroup(size_t count, const Boundary2f& boundary)
+GroupInteraction::GroupInteraction(float cohesion, float alignment, float separation)
 {
-	m_Size = Vec2f(1.0f, 1.0f);
-
-	m_Cohesion = 0.2f;
-	m_Separation = 0.5f;
-	m_Alignment = 0.3f;
-	m_Friendliness = 0.2f;
-
-	m_ViewDistance = 10.0f;
-	m_MinSeparationDistance = 40.0f;
-	m_MaxSpeed = 60.0f;
-
-	m_Color = Vec4f(0.1f, 0.8f, 0.3f);
-
-	setCount(count, boundary);
+	this->cohesion = cohesion;
+	this->alignment = alignment;
+	this->separation = separation;
 }
 
-float* BoidGroup::getCount()
+bool GroupInteraction::isIgnored() const
 {
-	return &m_Countf;
+	return cohesion == 0.0f && alignment == 0.0f && separation == 0.0f;
 }
 
-Vec2f& BoidGroup::getBoidSize()
+bool GroupInteraction::operator==(const GroupInteraction& other) const
 {
-	return m_Size;
+	return cohesion == other.cohesion && alignment == other.alignment && separation == other.separation;
 }
 
-float* BoidGroup::getBoidCohesion()
+bool GroupInteraction::operator!=(const GroupInteraction& other) const
 {
-	return &m_Cohesion;
+	return !(*this == other);
 }
 
-float* BoidGroup::getBoidSeparation()
-{
-	return &m_Separation;
-}
+/************************************************************************************************************
+*											SteeringSums
+*************************************************************************************************************/
 
-float* BoidGroup::getBoidAlignment()
+SteeringSums::SteeringSums()
 {
-	return &m_Alignment;
+	positionX = 0.0f;
+	positionY = 0.0f;
+	separationX = 0.0f;
+	separationY = 0.0f;
+	velocityX = 0.0f;
+	velocityY = 0.0f;
+	count = 0;
+	weighted = false;
+	cohesionWeight = 0.0f;
 }
 
-float* BoidGroup::getFriendliness()
+void SteeringSums::accumulate(const KernelOptions& options, const Vec2f& position, float minSeparationDistance, const SpatialGrid& grid,
+	const NeighborSpan& nearBoids, const float* viewDistances2)
 {
-	return &m_Friendliness;
-}
+	float sums[6] = { positionX, positionY, separationX, separationY, velocityX, velocityY };
 
-float* BoidGroup::getBoidViewDistance()
-{
-	return &m_ViewDistance;
-}
+	count += accumulateNeighbors(options, grid.getX(), grid.getY(), grid.getVX(), grid.getVY(), grid.getGroups(), viewDistances2,
+		nearBoids.begin(), nearBoids.size(), position.x, position.y, minSeparationDistance * minSeparationDistance, sums);
 
-float* BoidGroup::getBoidMinSeparationDistance()
-{
-	return &m_MinSeparationDistance;
+	positionX = sums[0];
+	positionY = sums[1];
+	separationX = sums[2];
+	separationY = sums[3];
+	velocityX = sums[4];
+	velocityY = sums[5];
 }
 
-float* BoidGroup::getBoidMaxSpeed()
+void SteeringSums::accumulate(const Vec2f& position, float minSeparationDistance, const SpatialGrid& grid, const NeighborSpan& nearBoids,
+	const float* viewDistances2, const GroupInteraction* interactions)
 {
-	return &m_MaxSpeed;
-}
+	const float* x = grid.getX();
+	const float* y = grid.getY();
+	const float* vx = grid.getVX();
+	const float* vy = grid.getVY();
+	const GroupId* groups = grid.getGroups();
+	float minDistance2 = minSeparationDistance * minSeparationDistance;
+
+	for (const uint32_t* neighbor = nearBoids.begin(); neighbor != nearBoids.end(); neighbor++)
+	{
+		uint32_t i = *neighbor;
+		float dx = position.x - x[i];
+		float dy = position.y - y[i];
+		float distance2 = dx * dx + dy * dy;
 
-Vec4f& BoidGroup::getBoidColor()
-{
-	return m_Color;
-}
+		if (viewDistances2 && distance2 > viewDistances2[groups[i]])
+		{
+			continue;
+		}
 
-GLuint BoidGroup::getBoidModel()
-{
-	return m_ModelList;
+		add(x[i], y[i], vx[i], vy[i], dx, dy, distance2, minDistance2, interactions[groups[i]]);
+	}
 }
 
-Vec2f BoidGroup::getAveragePosition() const
+void SteeringSums::add(float x, float y, float vx, float vy, float dx, float dy, float distance2, float minDistance2)
 {
-	Vec2f averagePosition(0.0f, 0.0f);
+	positionX += x;
+	positionY += y;
+	velocityX += vx;
+	velocityY += vy;
 
-	for (size_t i = 0; i < m_Boids.size(); i++)
+	// coincident boids have no direction to separate along, 0 / 0 would poison the whole school
+	if (distance2 > 0.0f)
 	{
-		averagePosition = averagePosition + m_Boids[i].getPosition();
-	}
+		float scale = distance2 / minDistance2;
 
-	if (!m_Boids.empty())
-	{
-		averagePosition = averagePosition / static_cast<float>(m_Boids.size());
+		separationX += dx / scale;
+		separationY += dy / scale;
 	}
 
-	return averagePosition;
+	count++;
 }
 
-Vec2f BoidGroup::getAverageVelocity() const
+void SteeringSums::add(float x, float y, float vx, float vy, float dx, float dy, float distance2, float minDistance2,
+	const GroupInteraction& interaction)
 {
-	Vec2f averageVelocity(0.0f, 0.0f);
+	positionX += x * interaction.cohesion;
+	positionY += y * interaction.cohesion;
+	velocityX += vx * interaction.alignment;
+	velocityY += vy * interaction.alignment;
 
-	for (size_t i = 0; i < m_Boids.size(); i++)
+	if (distance2 > 0.0f)
 	{
-		averageVelocity = averageVelocity + m_Boids[i].getVelocity();
+		float scale = distance2 / minDistance2;
+
+		separationX += dx / scale * interaction.separation;
+		separationY += dy / scale * interaction.separation;
 	}
 
-	if (!m_Boids.empty())
+	count++;
+	weighted = true;
+	cohesionWeight += interaction.cohesion;
+}
+
+void SteeringSums::add(const CellAggregate& aggregate, float dx, float dy, float distance2, float minDistance2)
+{
+	positionX += aggregate.positionX;
+	positionY += aggregate.positionY;
+	velocityX += aggregate.velocityX;
+	velocityY += aggregate.velocityY;
+
+	if (distance2 > 0.0f)
 	{
-		averageVelocity = averageVelocity / static_cast<float>(m_Boids.size());
+		float scale = distance2 / (minDistance2 * static_cast<float>(aggregate.count));
+
+		separationX += dx / scale;
+		separationY += dy / scale;
 	}
 
-	return averageVelocity;
+	count += aggregate.count;
 }
 
-std::vector<Boid>& BoidGroup::getBoids()
+void SteeringSums::add(const CellAggregate& aggregate, float dx, float dy, float distance2, float minDistance2,
+	const GroupInteraction& interaction)
 {
-	return m_Boids;
-}
+	float count = static_cast<float>(aggregate.count);
 
-void BoidGroup::setCount(size_t count, const Boundary2f& boundary)
-{	
-	m_Countf = static_cast<float>(count);
-	size_t oldCount = m_Boids.size();
-	m_Boids.resize(count);
+	positionX += aggregate.positionX * interaction.cohesion;
+	positionY += aggregate.positionY * interaction.cohesion;
+	velocityX += aggregate.velocityX * interaction.alignment;
+	velocityY += aggregate.velocityY * interaction.alignment;
 
-	for (size_t i = oldCount; i < m_Boids.size(); i++)
+	if (distance2 > 0.0f)
 	{
-		m_Boids[i].setPosition(Vec2f(rand_float() * boundary.max.x, rand_float() * boundary.max.y));
-		m_Boids[i].setVelocity(rand_direction() * (rand_float(0.5f, 1.0f) * m_MaxSpeed));
+		float scale = distance2 / (minDistance2 * count);
+
+		separationX += dx / scale * interaction.separation;
+		separationY += dy / scale * interaction.separation;
 	}
+
+	this->count += aggregate.count;
+	weighted = true;
+	cohesionWeight += count * interaction.cohesion;
 }
 
-void BoidGroup::setBoidSize(const Vec2f& v)
+/************************************************************************************************************
+*											BoidArray
+*************************************************************************************************************/
+
+BoidArray::BoidArray()
 {
-	m_Size = v;
+	m_Size = 0;
 }
 
-void BoidGroup::setBoidViewDistance(float viewDistance)
+size_t BoidArray::size() const
 {
-	m_ViewDistance = viewDistance;
+	return m_Size;
 }
 
-void BoidGroup::setBoidMinSeparationDistance(float minDistance)
+bool BoidArray::empty() const
 {
-	m_MinSeparationDistance = minDistance;
+	return m_Size == 0;
 }
 
-void BoidGroup::setBoidCohesion(float cohesion)
+Boid BoidArray::operator[](size_t index) const
 {
-	m_Cohesion = cohesion;
+	Boid boid;
+	boid.setPosition(getPosition(index));
+	boid.setVelocity(getVelocity(index));
+
+	return boid;
 }
 
-void BoidGroup::setBoidSeparation(float separation)
+Vec2f BoidArray::getPosition(size_t index) const
 {
-	m_Separation = separation;
+	return Vec2f(m_X[index], m_Y[index]);
 }
 
-void BoidGroup::setBoidAlignment(float alignment)
+Vec2f BoidArray::getVelocity(size_t index) const
 {
-	m_Alignment = alignment;
+	return Vec2f(m_VX[index], m_VY[index]);
 }
 
-void BoidGroup::setBoidFriendliness(float friendliness)
+void BoidArray::set(size_t index, const Boid& boid)
 {
-	m_Friendliness = friendliness;
+	setPosition(index, boid.getPosition());
+	setVelocity(index, boid.getVelocity());
 }
 
-
-void BoidGroup::setBoidMaxSpeed(float maxSpeed)
+void BoidArray::setPosition(size_t index, const Vec2f& v)
 {
-	m_MaxSpeed = maxSpeed;
+	m_X[index] = v.x;
+	m_Y[index] = v.y;
 }
 
-void BoidGroup::setBoidColor(const Vec4f& color)
+void BoidArray::setVelocity(size_t index, const Vec2f& v)
 {
-	m_Color = color;
+	m_VX[index] = v.x;
+	m_VY[index] = v.y;
 }
 
-void BoidGroup::update(float dt, BoidSystem& boidSystem)
-{	
-	setCount(static_cast<size_t>(m_Countf), *boidSystem.getBoidBoundary());
+void BoidArray::resize(size_t count)
+{
+	size_t padded = (count + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH;
 
-	for (size_t i = 0; i < m_Boids.size(); i++)
+	// shrinking must clear the tail so the padding stays zero
+	if (count < m_Size)
 	{
-		BoidSystem::findNearBoids(m_Boids[i], boidSystem);
-
-		m_Boids[i].cohere(m_Cohesion, BoidSystem::getNearFriendlyBoids(), 1.0f);
-		m_Boids[i].cohere(m_Cohesion, BoidSystem::getNearStrangerBoids(), m_Friendliness);
+		std::fill(m_X.begin() + count, m_X.begin() + m_Size, 0.0f);
+		std::fill(m_Y.begin() + count, m_Y.begin() + m_Size, 0.0f);
+		std::fill(m_VX.begin() + count, m_VX.begin() + m_Size, 0.0f);
+		std::fill(m_VY.begin() + count, m_VY.begin() + m_Size, 0.0f);
+	}
 
-		m_Boids[i].separate(m_Separation, m_MinSeparationDistance, BoidSystem::getNearFriendlyBoids(), 1.0f);
-		m_Boids[i].separate(m_Separation, m_MinSeparationDistance, BoidSystem::getNearStrangerBoids(), m_Friendliness);
+	m_X.resize(padded, 0.0f);
+	m_Y.resize(padded, 0.0f);
+	m_VX.resize(padded, 0.0f);
+	m_VY.resize(padded, 0.0f);
 
-		m_Boids[i].align(m_Alignment, BoidSystem::getNearFriendlyBoids(), 1.0f);
-		m_Boids[i].align(m_Alignment, BoidSystem::getNearStrangerBoids(), m_Friendliness);
+	m_Size = count;
+}
 
+void BoidArray::reserve(size_t count)
+{
+	size_t padded = (count + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH;
 
-		m_Boids[i].constrainBounds(*boidSystem.getBoidBoundary(), *boidSystem.getBoidBoundaryRepel());
-		m_Boids[i].constrainSpeed(m_MaxSpeed);
+	m_X.reserve(padded);
+	m_Y.reserve(padded);
+	m_VX.reserve(padded);
+	m_VY.reserve(padded);
+}
 
-		m_Boids[i].update(dt);
-	}
+void BoidArray::clear()
+{
+	resize(0);
 }
 
-void BoidGroup::draw() const
-{	
-	for (size_t i = 0; i < m_Boids.size(); i++)
+void BoidArray::push_back(const Vec2f& position, const Vec2f& velocity)
+{
+	if (m_Size == m_X.size())
 	{
-		m_Boids[i].draw(m_ModelList, m_Size, m_Color);
+		resize(m_Size + 1);
 	}
+	else
+	{
+		m_Size++;
+	}
+
+	setPosition(m_Size - 1, position);
+	setVelocity(m_Size - 1, velocity);
 }
 
-void BoidGroup::setModelList(GLuint modelList)
+float* BoidArray::getX()
 {
-	m_ModelList = modelList;
+	return m_X.data();
 }
 
-void BoidGroup::initModels()
+float* BoidArray::getY()
 {
-	m_ModelList = glGenLists(1);
-
-	glNewList(m_ModelList, GL_COMPILE);
-
-	glBegin(GL_TRIANGLES);
-	glVertexVec2f(Vec2f(0.66f, 0.0f));
-	glVertexVec2f(Vec2f(-0.33f, 0.94f));
-	glVertexVec2f(Vec2f(-0.33f, -0.94f));
-	glEnd();
-	glEndList();
+	return m_Y.data();
 }
 
-std::vector <Boid*> BoidSystem::m_NearFriendlyBoids;
-std::vector <Boid*> BoidSystem::m_NearStrangerBoids;
-
-BoidSystem::BoidSystem()
+float* BoidArray::getVX()
 {
-	m_BoundaryRepel = Vec2f(15.0f, 15.0f);
-
-	setCount(0);
+	return m_VX.data();
 }
 
-BoidSystem::BoidSystem(size_t count, const Boundary2f& boundary)
+float* BoidArray::getVY()
 {
-	m_BoundaryRepel = Vec2f(15.0f, 15.0f);
-	m_Boundary = boundary;
-
-	setCount(count);
+	return m_VY.data();
 }
 
-float* BoidSystem::getCount()
+const float* BoidArray::getX() const
 {
-	return &m_Countf;
+	return m_X.data();
 }
 
-Boundary2f* BoidSystem::getBoidBoundary()
+const float* BoidArray::getY() const
 {
-	return &m_Boundary;
+	return m_Y.data();
 }
 
-Vec2f* BoidSystem::getBoidBoundaryRepel()
+const float* BoidArray::getVX() const
 {
-	return &m_BoundaryRepel;
+	return m_VX.data();
 }
 
-BoidGroup& BoidSystem::getGroup(size_t index)
+const float* BoidArray::getVY() const
 {
-	return m_BoidGroups[index];
+	return m_VY.data();
 }
 
-void BoidSystem::setCount(size_t count)
-{
-	m_Countf = static_cast<float>(count);
-	size_t oldCount = m_BoidGroups.size();
-	m_BoidGroups.resize(count);
-	m_NearFriendlyBoids.reserve(300);
-	m_NearFriendlyBoids.clear();
-	m_NearStrangerBoids.reserve(300);
-	m_NearStrangerBoids.clear();
+/************************************************************************************************************
+*											BoidHandle
+*************************************************************************************************************/
 
-	for (size_t i = oldCount; i < m_BoidGroups.size(); i++)
-	{
-		m_BoidGroups[i].setCount(rand_int(30, 100), m_Boundary);
-	}
+BoidHandle::BoidHandle()
+{
+	slot = 0;
+	generation = 0;
 }
 
-void BoidSystem::update(float dt)
+BoidHandle::BoidHandle(uint32_t slot, uint32_t generation)
 {
-	for (size_t i = 0; i < m_BoidGroups.size(); i++)
-	{
-		m_BoidGroups[i].update(dt, *this);
-	}
+	this->slot = slot;
+	this->generation = generation;
 }
 
-void BoidSystem::draw() const
+bool BoidHandle::operator==(const BoidHandle& other) const
 {
-	for (size_t i = 0; i < m_BoidGroups.size(); i++) 
-	{
-		m_BoidGroups[i].draw();
-	}
+	return slot == other.slot && generation == other.generation;
 }
 
-void BoidSystem::setBoidBoundaryRepel(const Vec2f& v)
+bool BoidHandle::operator!=(const BoidHandle& other) const
 {
-	m_BoundaryRepel = v;
+	return !(*this == other);
 }
 
-BoidGroup& BoidSystem::addGroup()
+/************************************************************************************************************
+*											BoidGroup
+*************************************************************************************************************/
+
+const Vec2f BoidGroup::m_ModelVertices[3] =
 {
-	setCount(m_BoidGroups.size() + 1);
+	Vec2f(0.66f, 0.0f),
+	Vec2f(-0.33f, 0.94f),
+	Vec2f(-0.33f, -0.94f)
+};
+
+BoidGroup::BoidGroup()
+{
+	m_Size = Vec2f(1.0f, 1.0f);
+	m_Bounds = emptyBounds();
+	m_PositionSum = Vec2f(0.0f, 0.0f);
+	m_VelocitySum = Vec2f(0.0f, 0.0f);
+
+	m_Cohesion = 0.2f;
+	m_Separation = 0.5f;
+	m_Alignment = 0.3f;
+	m_Friendliness = 0.2f;
+
+	m_ViewDistance = 10.0f;
+	m_MinSeparationDistance = 40.0f;
+	m_MaxSpeed = 60.0f;
+	m_NearestCount = 0;
+	m_SlotEnd = 0;
+	m_Changed = false;
+	m_ParametersChanged = true;
+	m_HasPrevious = false;
+
+	m_Color = Vec4f(0.1f, 0.8f, 0.3f);
 
-	return m_BoidGroups.back();
+	setCount(30, Boundary2f(Vec2f(0.0f, 0.0f), Vec2f(800.0f, 600.0f)));
 }
 
-BoidGroup& BoidSystem::addGroup(size_t count)
+BoidGroup::BoidGroup(size_t count, const Boundary2f& boundary)
 {
-	m_Countf += 1.0f;
+	m_Size = Vec2f(1.0f, 1.0f);
+	m_Bounds = emptyBounds();
+	m_PositionSum = Vec2f(0.0f, 0.0f);
+	m_VelocitySum = Vec2f(0.0f, 0.0f);
 
-	m_BoidGroups.push_back(BoidGroup(count, m_Boundary));
+	m_Cohesion = 0.2f;
+	m_Separation = 0.5f;
+	m_Alignment = 0.3f;
+	m_Friendliness = 0.2f;
 
-	return m_BoidGroups.back();
+	m_ViewDistance = 10.0f;
+	m_MinSeparationDistance = 40.0f;
+	m_MaxSpeed = 60.0f;
+	m_NearestCount = 0;
+	m_SlotEnd = 0;
+	m_Changed = false;
+	m_ParametersChanged = true;
+	m_HasPrevious = false;
+
+	m_Color = Vec4f(0.1f, 0.8f, 0.3f);
+
+	setCount(count, boundary);
 }
 
-void BoidSystem::setBoidBoundary(const Boundary2f& bounds)
+float* BoidGroup::getCount()
 {
-	m_Boundary = bounds;
+	return &m_Countf;
 }
 
-void BoidSystem::findNearBoids(const Boid& boid, BoidSystem& boidSystem)
+Vec2f& BoidGroup::getBoidSize()
 {
-	m_NearFriendlyBoids.clear();
-	m_NearStrangerBoids.clear();
-
-	bool found = false;
-	std::vector<Boid*> boidAux;
-	boidAux.reserve(300);
+	return m_Size;
+}
 
-	for (size_t i = 0; i < boidSystem.m_BoidGroups.size(); i++)
-	{
-		std::vector <Boid>& boids = boidSystem.m_BoidGroups[i].getBoids();
-		for (size_t j = 0; j < boids.size(); j++)
+float* BoidGroup::getBoidCohesion()
+{
+	return &m_Cohesion;
+}
+
+float* BoidGroup::getBoidSeparation()
+{
+	return &m_Separation;
+}
+
+float* BoidGroup::getBoidAlignment()
+{
+	return &m_Alignment;
+}
+
+float* BoidGroup::getFriendliness()
+{
+	return &m_Friendliness;
+}
+
+const float* BoidGroup::getFriendliness() const
+{
+	return &m_Friendliness;
+}
+
+float* BoidGroup::getBoidViewDistance()
+{
+	return &m_ViewDistance;
+}
+
+const float* BoidGroup::getBoidViewDistance() const
+{
+	return &m_ViewDistance;
+}
+
+float* BoidGroup::getBoidMinSeparationDistance()
+{
+	return &m_MinSeparationDistance;
+}
+
+float* BoidGroup::getBoidMaxSpeed()
+{
+	return &m_MaxSpeed;
+}
+
+size_t BoidGroup::getNearestCount() const
+{
+	return m_NearestCount;
+}
+
+Vec4f& BoidGroup::getBoidColor()
+{
+	return m_Color;
+}
+
+Vec2f BoidGroup::getAveragePosition() const
+{
+	size_t liveCount = getLiveCount();
+
+	return liveCount ? m_PositionSum / static_cast<float>(liveCount) : Vec2f(0.0f, 0.0f);
+}
+
+Vec2f BoidGroup::getAverageVelocity() const
+{
+	size_t liveCount = getLiveCount();
+
+	return liveCount ? m_VelocitySum / static_cast<float>(liveCount) : Vec2f(0.0f, 0.0f);
+}
+
+const Boundary2f& BoidGroup::getBounds() const
+{
+	return m_Bounds;
+}
+
+void BoidGroup::updateSummary()
+{
+	IntegrationSummary summary;
+
+	for (size_t i = 0; i < m_Boids.size(); i++)
+	{
+		Vec2f position = m_Boids.getPosition(i);
+
+		summary.bounds.extend(position);
+		summary.positionSum += position;
+		summary.velocitySum += m_Boids.getVelocity(i);
+	}
+
+	applySummary(summary);
+
+	for (size_t i = 0; i < m_Despawned.size(); i++)
+	{
+		size_t index = m_Indices[m_Despawned[i]];
+
+		m_PositionSum -= m_Boids.getPosition(index);
+		m_VelocitySum -= m_Boids.getVelocity(index);
+	}
+}
+
+void BoidGroup::applySummary(const IntegrationSummary& summary)
+{
+	m_Bounds = summary.bounds;
+	m_PositionSum = summary.positionSum;
+	m_VelocitySum = summary.velocitySum;
+}
+
+BoidArray& BoidGroup::getBoids()
+{
+	return m_Boids;
+}
+
+const BoidArray& BoidGroup::getBoids() const
+{
+	return m_Boids;
+}
+
+size_t BoidGroup::getLiveCount() const
+{
+	return m_Boids.size() - m_Despawned.size();
+}
+
+BoidHandle BoidGroup::getBoidHandle(size_t index) const
+{
+	uint32_t slot = m_Ids[index];
+
+	return BoidHandle(slot, m_Generations[slot]);
+}
+
+bool BoidGroup::isAlive(const BoidHandle& handle) const
+{
+	return handle.slot < m_Generations.size() && m_Generations[handle.slot] == handle.generation && (handle.generation & 1);
+}
+
+size_t BoidGroup::getBoidIndex(const BoidHandle& handle) const
+{
+	return m_Indices[handle.slot];
+}
+
+BoidHandle BoidGroup::spawn(const Vec2f& position, const Vec2f& velocity)
+{
+	uint32_t slot;
+
+	if (m_FreeSlots.empty())
+	{
+		slot = static_cast<uint32_t>(m_Generations.size());
+		m_Generations.push_back(0);
+		m_Indices.push_back(0);
+	}
+	else
+	{
+		slot = m_FreeSlots.back();
+		m_FreeSlots.pop_back();
+	}
+
+	// the arrays grow geometrically, and the back buffer only needs to match in size
+	size_t index = m_Boids.size();
+	m_Boids.push_back(position, velocity);
+	m_BackBoids.resize(m_Boids.size());
+	m_Ids.push_back(slot);
+	m_BackIds.push_back(slot);
+
+	m_Generations[slot]++;
+	m_Indices[slot] = static_cast<uint32_t>(index);
+	m_SlotEnd = std::max(m_SlotEnd, static_cast<size_t>(slot) + 1);
+	m_Changed = true;
+	m_HasPrevious = false;
+	// the count follows the live boids
+	m_Countf += 1.0f;
+	m_Bounds.extend(position);
+	m_PositionSum += position;
+	m_VelocitySum += velocity;
+
+	return BoidHandle(slot, m_Generations[slot]);
+}
+
+bool BoidGroup::despawn(const BoidHandle& handle)
+{
+	if (!isAlive(handle))
+	{
+		return false;
+	}
+
+	// the box keeps the boid until the next integration, the averages lose it now
+	size_t index = m_Indices[handle.slot];
+	m_PositionSum -= m_Boids.getPosition(index);
+	m_VelocitySum -= m_Boids.getVelocity(index);
+
+	m_Generations[handle.slot]++;
+	m_Despawned.push_back(handle.slot);
+	m_Changed = true;
+	m_Countf -= 1.0f;
+
+	return true;
+}
+
+bool BoidGroup::compact()
+{
+	if (!m_Changed)
+	{
+		return false;
+	}
+
+	updateDespawnedIndices();
+
+	size_t count = m_Boids.size();
+	for (size_t i = 0; i < m_DespawnedIndices.size(); i++)
+	{
+		size_t hole = m_DespawnedIndices[i];
+		size_t last = --count;
+
+		if (hole != last)
+		{
+			m_Boids.set(hole, m_Boids[last]);
+			m_Ids[hole] = m_Ids[last];
+			m_Indices[m_Ids[last]] = static_cast<uint32_t>(hole);
+		}
+	}
+
+	m_Boids.resize(count);
+	m_BackBoids.resize(count);
+	m_Ids.resize(count);
+	m_BackIds.resize(count);
+
+	// the slot despawned last is reused first; setCount despawns from the top, so a growth takes the lowest back first
+	m_FreeSlots.insert(m_FreeSlots.end(), m_Despawned.begin(), m_Despawned.end());
+	m_Despawned.clear();
+	m_Changed = false;
+	m_HasPrevious = false;
+
+	return true;
+}
+
+// filling the holes from the highest index down only ever moves boids that stay alive
+void BoidGroup::updateDespawnedIndices()
+{
+	m_DespawnedIndices.resize(m_Despawned.size());
+	for (size_t i = 0; i < m_Despawned.size(); i++)
+	{
+		m_DespawnedIndices[i] = m_Indices[m_Despawned[i]];
+	}
+	std::sort(m_DespawnedIndices.begin(), m_DespawnedIndices.end(), std::greater<uint32_t>());
+}
+
+void BoidGroup::setCount(size_t count, const Boundary2f& boundary)
+{
+	size_t liveCount = getLiveCount();
+
+	while (liveCount > count && m_SlotEnd > 0)
+	{
+		uint32_t slot = static_cast<uint32_t>(--m_SlotEnd);
+
+		if (despawn(BoidHandle(slot, m_Generations[slot])))
+		{
+			liveCount--;
+		}
+	}
+
+	for (; liveCount < count; liveCount++)
+	{
+		Vec2f position(rand_float() * boundary.max.x, rand_float() * boundary.max.y);
+		Vec2f velocity = rand_direction() * (rand_float(0.5f, 1.0f) * m_MaxSpeed);
+
+		spawn(position, velocity);
+	}
+
+	m_Countf = static_cast<float>(count);
+}
+
+void BoidGroup::setBoidSize(const Vec2f& v)
+{
+	m_Size = v;
+}
+
+void BoidGroup::setBoidViewDistance(float viewDistance)
+{
+	m_ViewDistance = viewDistance;
+	m_ParametersChanged = true;
+}
+
+void BoidGroup::setBoidMinSeparationDistance(float minDistance)
+{
+	m_MinSeparationDistance = minDistance;
+	m_ParametersChanged = true;
+}
+
+void BoidGroup::setBoidCohesion(float cohesion)
+{
+	m_Cohesion = cohesion;
+}
+
+void BoidGroup::setBoidSeparation(float separation)
+{
+	m_Separation = separation;
+}
+
+void BoidGroup::setBoidAlignment(float alignment)
+{
+	m_Alignment = alignment;
+}
+
+void BoidGroup::setBoidFriendliness(float friendliness)
+{
+	m_Friendliness = friendliness;
+	m_ParametersChanged = true;
+}
+
+
+void BoidGroup::setBoidMaxSpeed(float maxSpeed)
+{
+	m_MaxSpeed = maxSpeed;
+}
+
+void BoidGroup::setNearestCount(size_t count)
+{
+	m_NearestCount = count;
+	m_ParametersChanged = true;
+}
+
+void BoidGroup::setBoidColor(const Vec4f& color)
+{
+	m_Color = color;
+}
+
+void BoidGroup::steer(size_t begin, size_t end, size_t firstBoid, const SpatialGrid& grid, const NeighborTable& neighbors,
+	const float* viewDistances2, const GroupInteraction* weights, const GroupInteraction* strangerInteractions,
+	const KernelOptions& options)
+{
+	// the nearest boids count however far they are
+	if (m_NearestCount)
+	{
+		viewDistances2 = nullptr;
+	}
+
+	for (size_t i = begin; i < end; i++)
+	{
+		Boid boid = m_Boids[i];
+
+		boid.steer(m_Cohesion, m_Separation, m_Alignment, m_MinSeparationDistance, grid, neighbors.getFriendly(firstBoid + i),
+			neighbors.getStrangers(firstBoid + i), viewDistances2, weights, strangerInteractions, options);
+
+		m_BackBoids.set(i, boid);
+	}
+}
+
+void BoidGroup::steer(size_t begin, size_t end, size_t firstBoid, const SpatialGrid& grid, const SteeringSums* pairSums,
+	const GroupInteraction* weights)
+{
+	for (size_t i = begin; i < end; i++)
+	{
+		Boid boid = m_Boids[i];
+
+		boid.steer(m_Cohesion, m_Separation, m_Alignment, pairSums + 2 * grid.getEntry(firstBoid + i), weights);
+
+		m_BackBoids.set(i, boid);
+	}
+}
+
+void BoidGroup::integrate(size_t begin, size_t end, float dt, const Boundary2f& bounds, const Vec2f& boundaryRepel, SimdLevel level,
+	IntegrationSummary& summary)
+{
+	integrateBoids(level, m_BackBoids.getX() + begin, m_BackBoids.getY() + begin, m_BackBoids.getVX() + begin,
+		m_BackBoids.getVY() + begin, end - begin, dt, bounds, boundaryRepel, m_MaxSpeed, summary);
+}
+
+void BoidGroup::swapBuffers()
+{
+	std::swap(m_Boids, m_BackBoids);
+	m_HasPrevious = true;
+}
+
+void BoidGroup::reorder(size_t begin, size_t end, const uint32_t* order, size_t firstBoid)
+{
+	const float* x = m_Boids.getX();
+	const float* y = m_Boids.getY();
+	const float* vx = m_Boids.getVX();
+	const float* vy = m_Boids.getVY();
+	float* backX = m_BackBoids.getX();
+	float* backY = m_BackBoids.getY();
+	float* backVX = m_BackBoids.getVX();
+	float* backVY = m_BackBoids.getVY();
+
+	for (size_t i = begin; i < end; i++)
+	{
+		size_t from = order[i] - firstBoid;
+		uint32_t id = m_Ids[from];
+
+		backX[i] = x[from];
+		backY[i] = y[from];
+		backVX[i] = vx[from];
+		backVY[i] = vy[from];
+		m_BackIds[i] = id;
+		m_Indices[id] = static_cast<uint32_t>(i);
+	}
+}
+
+void BoidGroup::swapOrder()
+{
+	std::swap(m_Boids, m_BackBoids);
+	std::swap(m_Ids, m_BackIds);
+}
+
+void BoidGroup::prepareInstances(size_t begin, size_t end, float interpolation, BoidInstance* instances) const
+{
+	const float* x = m_Boids.getX();
+	const float* y = m_Boids.getY();
+	const float* vx = m_Boids.getVX();
+	const float* vy = m_Boids.getVY();
+
+	// without a previous state the boids are drawn where they are now
+	const float* previousX = m_HasPrevious ? m_BackBoids.getX() : x;
+	const float* previousY = m_HasPrevious ? m_BackBoids.getY() : y;
+
+	for (size_t i = begin; i < end; i++)
+	{
+		float length2 = vx[i] * vx[i] + vy[i] * vy[i];
+		float invLength = length2 > 0.0f ? 1.0f / sqrtf(length2) : 0.0f;
+
+		instances[i].x = previousX[i] + (x[i] - previousX[i]) * interpolation;
+		instances[i].y = previousY[i] + (y[i] - previousY[i]) * interpolation;
+		instances[i].directionX = length2 > 0.0f ? vx[i] * invLength : 1.0f;
+		instances[i].directionY = vy[i] * invLength;
+	}
+}
+
+void BoidGroup::removeDespawnedInstances(BoidInstance* instances)
+{
+	if (m_Despawned.empty())
+	{
+		return;
+	}
+
+	updateDespawnedIndices();
+
+	size_t count = m_Boids.size();
+	for (size_t i = 0; i < m_DespawnedIndices.size(); i++)
+	{
+		instances[m_DespawnedIndices[i]] = instances[--count];
+	}
+}
+
+const Vec2f* BoidGroup::getModelVertices()
+{
+	return m_ModelVertices;
+}
+
+size_t BoidGroup::getModelVertexCount()
+{
+	return sizeof(m_ModelVertices) / sizeof(m_ModelVertices[0]);
+}
+
+/************************************************************************************************************
+*											ParameterChange
+*************************************************************************************************************/
+
+ParameterChange::ParameterChange()
+{
+	group = 0;
+	parameter = GroupParameter::Cohesion;
+	value = 0.0f;
+}
+
+ParameterChange::ParameterChange(size_t group, GroupParameter parameter, float value)
+{
+	this->group = group;
+	this->parameter = parameter;
+	this->value = value;
+}
+
+/************************************************************************************************************
+*											BoidSystem
+*************************************************************************************************************/
+
+BoidSystem::BoidSystem()
+{
+	m_BoundaryRepel = Vec2f(15.0f, 15.0f);
+	m_Reordering = false;
+	m_CellSize = 0.0f;
+	m_NeighborSkin = 0.0f;
+	m_NeighborsBuilt = false;
+	m_Pairwise = false;
+	m_SummedNeighborCount = 0;
+	m_MeanField = false;
+	m_MeanFieldError = 0.5f;
+	m_ParametersChanged = true;
+	m_GroupOffsets.assign(1, 0);
+	m_Scratch.resize(m_ThreadPool.getThreadCount());
+
+	setCount(0);
+}
+
+BoidSystem::BoidSystem(size_t count, const Boundary2f& boundary)
+{
+	m_BoundaryRepel = Vec2f(15.0f, 15.0f);
+	m_Reordering = false;
+	m_CellSize = 0.0f;
+	m_NeighborSkin = 0.0f;
+	m_NeighborsBuilt = false;
+	m_Pairwise = false;
+	m_SummedNeighborCount = 0;
+	m_MeanField = false;
+	m_MeanFieldError = 0.5f;
+	m_ParametersChanged = true;
+	m_GroupOffsets.assign(1, 0);
+	m_Scratch.resize(m_ThreadPool.getThreadCount());
+	m_Boundary = boundary;
+
+	setCount(count);
+}
+
+float* BoidSystem::getCount()
+{
+	return &m_Countf;
+}
+
+Boundary2f* BoidSystem::getBoidBoundary()
+{
+	return &m_Boundary;
+}
+
+const Boundary2f* BoidSystem::getBoidBoundary() const
+{
+	return &m_Boundary;
+}
+
+Vec2f* BoidSystem::getBoidBoundaryRepel()
+{
+	return &m_BoundaryRepel;
+}
+
+const Vec2f* BoidSystem::getBoidBoundaryRepel() const
+{
+	return &m_BoundaryRepel;
+}
+
+BoidGroup& BoidSystem::getGroup(size_t index)
+{
+	return m_BoidGroups[index];
+}
+
+void BoidSystem::setCount(size_t count)
+{
+	count = std::min(count, MAX_GROUPS);
+	m_Countf = static_cast<float>(count);
+	m_ParametersChanged = true;
+	size_t oldCount = m_BoidGroups.size();
+	m_BoidGroups.resize(count);
+
+	for (size_t i = oldCount; i < m_BoidGroups.size(); i++)
+	{
+		m_BoidGroups[i].setCount(rand_int(30, 100), m_Boundary);
+	}
+}
+
+void BoidSystem::update(float dt)
+{
+	typedef std::chrono::steady_clock Clock;
+
+	Clock::time_point start = Clock::now();
+	bool rebuilt = !refreshNeighbors();
+	if (rebuilt)
+	{
+		rebuildGrid();
+		if (m_Reordering)
+		{
+			reorderBoids();
+		}
+		findNeighbors();
+	}
+	if (m_MeanField)
+	{
+		accumulateMeanField();
+	}
+	else if (m_Pairwise)
+	{
+		accumulatePairs();
+	}
+	Clock::time_point searched = Clock::now();
+
+	// boids read the current tick and write the next one, so the result does not depend
+	// on the thread count or on the order of the boids
+	steer();
+	Clock::time_point steered = Clock::now();
+
+	integrate(dt);
+	swapBuffers();
+	Clock::time_point integrated = Clock::now();
+
+	m_UpdateStats.neighborSeconds = std::chrono::duration<double>(searched - start).count();
+	m_UpdateStats.steeringSeconds = std::chrono::duration<double>(steered - searched).count();
+	m_UpdateStats.integrationSeconds = std::chrono::duration<double>(integrated - steered).count();
+	m_UpdateStats.boidCount = m_GroupOffsets.back();
+	m_UpdateStats.neighborCount = getNeighborCount();
+	m_UpdateStats.maxNeighbors = 0;
+	m_UpdateStats.neighborsRebuilt = rebuilt;
+
+	for (size_t i = 0; i < m_Scratch.size(); i++)
+	{
+		m_UpdateStats.maxNeighbors = std::max(m_UpdateStats.maxNeighbors, m_Scratch[i].maxNeighbors);
+	}
+}
+
+bool BoidSystem::refreshNeighbors()
+{
+	// the aggregates are only valid for the cells they were summed in
+	if (m_NeighborSkin <= 0.0f || !m_NeighborsBuilt || m_MeanField)
+	{
+		return false;
+	}
+
+	applyGroupChanges();
+
+	// lists of a different set of boids or built for other radii are useless
+	if (!m_NeighborsBuilt || m_GroupOffsets != m_BuildGroupOffsets || m_PairViewDistances2 != m_BuildPairViewDistances2 ||
+		m_NearestCounts != m_BuildNearestCounts)
+	{
+		return false;
+	}
+
+	// the skin bounds how far the boids of a kept list moved, not whether they are still the nearest ones
+	for (size_t i = 0; i < m_NearestCounts.size(); i++)
+	{
+		if (m_NearestCounts[i])
+		{
+			return false;
+		}
+	}
+
+	for (size_t i = 0; i < m_Scratch.size(); i++)
+	{
+		m_Scratch[i].maxDisplacement2 = 0.0f;
+	}
+
+	runGroups([this](size_t group, size_t begin, size_t end, size_t worker)
+	{
+		const BoidArray& boids = m_BoidGroups[group].getBoids();
+		const float* x = boids.getX();
+		const float* y = boids.getY();
+		const float* buildX = m_BuildX.data() + m_GroupOffsets[group];
+		const float* buildY = m_BuildY.data() + m_GroupOffsets[group];
+		float maxDisplacement2 = m_Scratch[worker].maxDisplacement2;
+
+		for (size_t i = begin; i < end; i++)
+		{
+			float dx = x[i] - buildX[i];
+			float dy = y[i] - buildY[i];
+
+			maxDisplacement2 = std::max(maxDisplacement2, dx * dx + dy * dy);
+		}
+
+		m_Scratch[worker].maxDisplacement2 = maxDisplacement2;
+	});
+
+	// two boids that each moved less than half the skin are still in each other's list if they can see each other
+	float maxDisplacement = m_NeighborSkin * 0.5f;
+	for (size_t i = 0; i < m_Scratch.size(); i++)
+	{
+		if (m_Scratch[i].maxDisplacement2 > maxDisplacement * maxDisplacement)
+		{
+			return false;
+		}
+	}
+
+	m_Grid.refresh(m_BoidGroups, m_GroupOffsets, m_ThreadPool);
+
+	return true;
+}
+
+void BoidSystem::rebuildGrid()
+{
+	applyGroupChanges();
+
+	if (m_MeanField)
+	{
+		m_Grid.rebuild(m_BoidGroups, m_GroupOffsets, m_Boundary, m_CellSize / m_MeanFieldDivisions, m_ThreadPool);
+		m_Grid.aggregate(m_BoidGroups.size(), m_ThreadPool);
+	}
+	else
+	{
+		m_Grid.rebuild(m_BoidGroups, m_GroupOffsets, m_Boundary, m_CellSize, m_ThreadPool);
+	}
+}
+
+void BoidSystem::reorderBoids()
+{
+	m_Grid.sortBoids(m_GroupOffsets, m_Order, m_ThreadPool);
+
+	runGroups([this](size_t group, size_t begin, size_t end, size_t /*worker*/)
+	{
+		m_BoidGroups[group].reorder(begin, end, m_Order.data() + m_GroupOffsets[group], m_GroupOffsets[group]);
+	});
+
+	for (size_t i = 0; i < m_BoidGroups.size(); i++)
+	{
+		m_BoidGroups[i].swapOrder();
+	}
+}
+
+void BoidSystem::findNeighbors()
+{
+	m_Neighbors.reset(m_GroupOffsets.back(), m_Scratch.size());
+	updateReachableGroups();
+
+	for (size_t i = 0; i < m_Scratch.size(); i++)
+	{
+		m_Scratch[i].maxNeighbors = 0;
+	}
+
+	m_ThreadPool.run(m_GroupOffsets.back(), [this](size_t begin, size_t end, size_t worker)
+	{
+		std::vector<uint32_t>& buffer = m_Neighbors.getWorkerBuffer(worker);
+		NeighborScratch& scratch = m_Scratch[worker];
+
+		for (size_t i = begin; i < end; i++)
+		{
+			size_t listBegin = buffer.size();
+			size_t nearestCount = m_NearestCounts[m_Grid.getGroups()[m_Grid.getEntry(i)]];
+
+			scratch.strangerBoids.clear();
+			if (nearestCount)
+			{
+				findNearestBoids(i, nearestCount, scratch.nearestBoids, buffer, scratch.strangerBoids);
+			}
+			// pairwise and mean-field steering read the grid directly, the other boids get empty lists
+			else if (!m_Pairwise && !m_MeanField)
+			{
+				findNearBoids(i, buffer, scratch.strangerBoids);
+			}
+
+			size_t friendlyCount = buffer.size() - listBegin;
+			buffer.insert(buffer.end(), scratch.strangerBoids.begin(), scratch.strangerBoids.end());
+
+			m_Neighbors.addList(i, worker, listBegin, friendlyCount, scratch.strangerBoids.size());
+			scratch.maxNeighbors = std::max(scratch.maxNeighbors, buffer.size() - listBegin);
+		}
+	});
+
+	m_Neighbors.commit();
+
+	m_ThreadPool.run(m_GroupOffsets.back(), [this](size_t begin, size_t end, size_t /*worker*/)
+	{
+		m_Neighbors.compact(begin, end);
+	});
+
+	if (m_NeighborSkin > 0.0f)
+	{
+		m_BuildGroupOffsets = m_GroupOffsets;
+		m_BuildPairViewDistances2 = m_PairViewDistances2;
+		m_BuildNearestCounts = m_NearestCounts;
+		m_BuildX.resize(m_GroupOffsets.back());
+		m_BuildY.resize(m_GroupOffsets.back());
+
+		m_ThreadPool.run(m_GroupOffsets.back(), [this](size_t begin, size_t end, size_t /*worker*/)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				uint32_t entry = m_Grid.getEntry(i);
+
+				m_BuildX[i] = m_Grid.getX()[entry];
+				m_BuildY[i] = m_Grid.getY()[entry];
+			}
+		});
+	}
+
+	m_NeighborsBuilt = true;
+}
+
+void BoidSystem::accumulatePairs()
+{
+	size_t entryCount = m_Grid.getEntryCount();
+	m_EntrySums.resize(2 * entryCount);
+
+	m_ThreadPool.run(m_EntrySums.size(), [this](size_t begin, size_t end, size_t /*worker*/)
+	{
+		std::fill(m_EntrySums.begin() + begin, m_EntrySums.begin() + end, SteeringSums());
+	});
+
+	// a row writes to its own boids and to those of the next row, so the even rows can run in parallel
+	// and then the odd ones; every boid receives its neighbors in the same order whatever the thread count
+	for (int phase = 0; phase < 2; phase++)
+	{
+		size_t rowCount = (m_Grid.getRows() - phase + 1) / 2;
+
+		m_ThreadPool.run(rowCount, 1, [this, phase](size_t begin, size_t end, size_t /*worker*/)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				accumulateRow(static_cast<int>(2 * i) + phase);
+			}
+		});
+	}
+
+	updateSummedStats();
+}
+
+void BoidSystem::accumulateMeanField()
+{
+	size_t entryCount = m_Grid.getEntryCount();
+	m_EntrySums.resize(2 * entryCount);
+
+	float maxViewDistance2 = 0.0f;
+	for (size_t i = 0; i < m_ViewDistances2.size(); i++)
+	{
+		maxViewDistance2 = std::max(maxViewDistance2, m_ViewDistances2[i]);
+	}
+	int reach = static_cast<int>(std::ceil(std::sqrt(maxViewDistance2) / m_Grid.getCellSize()));
+
+	// every boid writes only its own sums
+	m_ThreadPool.run(entryCount, [this, reach, maxViewDistance2](size_t begin, size_t end, size_t /*worker*/)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			SteeringSums* sums = m_EntrySums.data() + 2 * i;
+
+			sums[0] = SteeringSums();
+			sums[1] = SteeringSums();
+			if (!m_NearestCounts[m_Grid.getGroups()[i]])
+			{
+				accumulateCells(static_cast<uint32_t>(i), reach, maxViewDistance2, sums);
+			}
+		}
+	});
+
+	updateSummedStats();
+}
+
+void BoidSystem::accumulateCells(uint32_t entry, int reach, float maxViewDistance2, SteeringSums* sums) const
+{
+	const SpatialGrid& grid = m_Grid;
+	const float* x = grid.getX();
+	const float* y = grid.getY();
+	const float* vx = grid.getVX();
+	const float* vy = grid.getVY();
+	const GroupId* groups = grid.getGroups();
+	size_t groupCount = m_BoidGroups.size();
+	GroupId group = groups[entry];
+	const float* viewDistances2 = m_PairViewDistances2.data() + group * groupCount;
+	const GroupInteraction* interactions = m_WeightedStrangers[group] ? m_Interactions.data() + group * groupCount : nullptr;
+	float minDistance2 = m_MinDistances2[group];
+	float cellSize = grid.getCellSize();
+	float error2 = m_MeanFieldError * m_MeanFieldError;
+	Vec2f origin = grid.getOrigin();
+	float positionX = x[entry];
+	float positionY = y[entry];
+	int columns = grid.getColumns();
+	int rows = grid.getRows();
+	int column = grid.getColumn(positionX);
+	int row = grid.getRow(positionY);
+
+	for (int cellRow = std::max(row - reach, 0); cellRow <= std::min(row + reach, rows - 1); cellRow++)
+	{
+		float top = origin.y + cellRow * cellSize;
+
+		for (int cellColumn = std::max(column - reach, 0); cellColumn <= std::min(column + reach, columns - 1); cellColumn++)
+		{
+			// the nearest and the farthest point of the cell; border cells also hold the boids clamped into them,
+			// so their extent is unknown and they are always scanned
+			bool border = cellColumn == 0 || cellRow == 0 || cellColumn == columns - 1 || cellRow == rows - 1;
+			float left = origin.x + cellColumn * cellSize;
+			float nearX = std::max(std::max(left - positionX, positionX - left - cellSize), 0.0f);
+			float nearY = std::max(std::max(top - positionY, positionY - top - cellSize), 0.0f);
+			float farX = std::max(positionX - left, left + cellSize - positionX);
+			float farY = std::max(positionY - top, top + cellSize - positionY);
+			float near2 = border ? 0.0f : nearX * nearX + nearY * nearY;
+			float far2 = farX * farX + farY * farY;
+
+			if (near2 > maxViewDistance2)
+			{
+				continue;
+			}
+
+			uint32_t begin = grid.cellBegin(cellColumn, cellRow);
+			uint32_t end = grid.cellEnd(cellColumn, cellRow);
+
+			if (begin == end)
+			{
+				continue;
+			}
+
+			// an aggregate per group only pays off for cells that hold more boids than that
+			bool distant = !border && end - begin > groupCount && cellSize * cellSize <= error2 * near2;
+			bool scan = !distant;
+
+			if (distant)
+			{
+				const CellAggregate* aggregates = grid.getAggregates(cellColumn, cellRow);
+
+				for (size_t i = 0; i < groupCount; i++)
+				{
+					const CellAggregate& aggregate = aggregates[i];
+
+					if (!aggregate.count || near2 > viewDistances2[i])
+					{
+						continue;
+					}
+					if (far2 <= viewDistances2[i])
+					{
+						float count = static_cast<float>(aggregate.count);
+						float dx = positionX - aggregate.positionX / count;
+						float dy = positionY - aggregate.positionY / count;
+
+						if (i == group)
+						{
+							sums[0].add(aggregate, dx, dy, dx * dx + dy * dy, minDistance2);
+						}
+						else if (interactions)
+						{
+							sums[1].add(aggregate, dx, dy, dx * dx + dy * dy, minDistance2, interactions[i]);
+						}
+						else
+						{
+							sums[1].add(aggregate, dx, dy, dx * dx + dy * dy, minDistance2);
+						}
+					}
+					else
+					{
+						scan = true;
+					}
+				}
+			}
+
+			if (!scan)
+			{
+				continue;
+			}
+
+			for (uint32_t i = begin; i < end; i++)
+			{
+				GroupId otherGroup = groups[i];
+				float viewDistance2 = viewDistances2[otherGroup];
+
+				// skips the groups added as aggregates above
+				if (i == entry || (distant && far2 <= viewDistance2))
+				{
+					continue;
+				}
+
+				float dx = positionX - x[i];
+				float dy = positionY - y[i];
+				float distance2 = dx * dx + dy * dy;
+
+				if (distance2 > viewDistance2)
+				{
+					continue;
+				}
+
+				if (otherGroup == group)
+				{
+					sums[0].add(x[i], y[i], vx[i], vy[i], dx, dy, distance2, minDistance2);
+				}
+				else if (interactions)
+				{
+					sums[1].add(x[i], y[i], vx[i], vy[i], dx, dy, distance2, minDistance2, interactions[otherGroup]);
+				}
+				else
+				{
+					sums[1].add(x[i], y[i], vx[i], vy[i], dx, dy, distance2, minDistance2);
+				}
+			}
+		}
+	}
+}
+
+void BoidSystem::updateSummedStats()
+{
+	for (size_t i = 0; i < m_Scratch.size(); i++)
+	{
+		m_Scratch[i].neighborCount = 0;
+		m_Scratch[i].maxNeighbors = 0;
+	}
+
+	m_ThreadPool.run(m_Grid.getEntryCount(), [this](size_t begin, size_t end, size_t worker)
+	{
+		NeighborScratch& scratch = m_Scratch[worker];
+
+		for (size_t i = begin; i < end; i++)
+		{
+			size_t boid = m_Grid.getBoid(static_cast<uint32_t>(i));
+			size_t count = m_EntrySums[2 * i].count + m_EntrySums[2 * i + 1].count +
+				m_Neighbors.getFriendly(boid).size() + m_Neighbors.getStrangers(boid).size();
+
+			scratch.neighborCount += count;
+			scratch.maxNeighbors = std::max(scratch.maxNeighbors, count);
+		}
+	});
+
+	m_SummedNeighborCount = 0;
+	for (size_t i = 0; i < m_Scratch.size(); i++)
+	{
+		m_SummedNeighborCount += m_Scratch[i].neighborCount;
+	}
+}
+
+void BoidSystem::accumulateRow(int row)
+{
+	const SpatialGrid& grid = m_Grid;
+	const float* x = grid.getX();
+	const float* y = grid.getY();
+	const float* vx = grid.getVX();
+	const float* vy = grid.getVY();
+	const GroupId* groups = grid.getGroups();
+	const float* viewDistances2 = m_PairViewDistances2.data();
+	const GroupInteraction* interactions = m_Interactions.data();
+	const uint8_t* weightedStrangers = m_WeightedStrangers.data();
+	const float* minDistances2 = m_MinDistances2.data();
+	const uint32_t* nearestCounts = m_NearestCounts.data();
+	size_t groupCount = m_BoidGroups.size();
+	SteeringSums* sums = m_EntrySums.data();
+
+	// adds boid j to the sums of boid i
+	auto addTo = [&](uint32_t i, GroupId groupI, uint32_t j, GroupId groupJ, float dx, float dy, float distance2)
+	{
+		if (groupI == groupJ)
+		{
+			sums[2 * i].add(x[j], y[j], vx[j], vy[j], dx, dy, distance2, minDistances2[groupI]);
+		}
+		else if (weightedStrangers[groupI])
+		{
+			sums[2 * i + 1].add(x[j], y[j], vx[j], vy[j], dx, dy, distance2, minDistances2[groupI],
+				interactions[groupI * groupCount + groupJ]);
+		}
+		else
+		{
+			sums[2 * i + 1].add(x[j], y[j], vx[j], vy[j], dx, dy, distance2, minDistances2[groupI]);
+		}
+	};
+
+	// each boid sees the other if it is within the view distance of the other's group and does not ignore it,
+	// the distance is shared; boids that steer by their nearest boids have lists instead
+	auto visit = [&](uint32_t i, uint32_t j)
+	{
+		float dx = x[i] - x[j];
+		float dy = y[i] - y[j];
+		float distance2 = dx * dx + dy * dy;
+		GroupId groupI = groups[i];
+		GroupId groupJ = groups[j];
+
+		if (distance2 <= viewDistances2[groupI * groupCount + groupJ] && !nearestCounts[groupI])
+		{
+			addTo(i, groupI, j, groupJ, dx, dy, distance2);
+		}
+		if (distance2 <= viewDistances2[groupJ * groupCount + groupI] && !nearestCounts[groupJ])
+		{
+			addTo(j, groupJ, i, groupI, -dx, -dy, distance2);
+		}
+	};
+
+	auto visitCells = [&](uint32_t begin, uint32_t end, int column, int otherRow)
+	{
+		uint32_t otherBegin = grid.cellBegin(column, otherRow);
+		uint32_t otherEnd = grid.cellEnd(column, otherRow);
+
+		for (uint32_t i = begin; i < end; i++)
+		{
+			for (uint32_t j = otherBegin; j < otherEnd; j++)
+			{
+				visit(i, j);
+			}
+		}
+	};
+
+	int columns = grid.getColumns();
+	int rows = grid.getRows();
+
+	for (int column = 0; column < columns; column++)
+	{
+		uint32_t begin = grid.cellBegin(column, row);
+		uint32_t end = grid.cellEnd(column, row);
+
+		if (begin == end)
+		{
+			continue;
+		}
+
+		for (uint32_t i = begin; i < end; i++)
+		{
+			for (uint32_t j = i + 1; j < end; j++)
+			{
+				visit(i, j);
+			}
+		}
+
+		// half of the surrounding cells, the other half visits this one
+		if (column + 1 < columns)
+		{
+			visitCells(begin, end, column + 1, row);
+		}
+		if (row + 1 < rows)
+		{
+			for (int otherColumn = std::max(column - 1, 0); otherColumn <= std::min(column + 1, columns - 1); otherColumn++)
+			{
+				visitCells(begin, end, otherColumn, row + 1);
+			}
+		}
+	}
+}
+
+void BoidSystem::steer()
+{
+	runGroups([this](size_t group, size_t begin, size_t end, size_t /*worker*/)
+	{
+		size_t row = group * m_BoidGroups.size();
+		const GroupInteraction* weights = m_SteeringWeights.data() + 2 * group;
+
+		if ((m_Pairwise || m_MeanField) && !m_NearestCounts[group])
+		{
+			m_BoidGroups[group].steer(begin, end, m_GroupOffsets[group], m_Grid, m_EntrySums.data(), weights);
+		}
+		else
+		{
+			m_BoidGroups[group].steer(begin, end, m_GroupOffsets[group], m_Grid, m_Neighbors, m_PairViewDistances2.data() + row,
+				weights, m_WeightedStrangers[group] ? m_Interactions.data() + row : nullptr, m_KernelOptions);
+		}
+	});
+}
+
+void BoidSystem::integrate(float dt)
+{
+	for (size_t i = 0; i < m_Scratch.size(); i++)
+	{
+		m_Scratch[i].groupSummaries.assign(m_BoidGroups.size(), IntegrationSummary());
+	}
+
+	runGroups([this, dt](size_t group, size_t begin, size_t end, size_t worker)
+	{
+		m_BoidGroups[group].integrate(begin, end, dt, m_Boundary, m_BoundaryRepel, m_KernelOptions.simdLevel,
+			m_Scratch[worker].groupSummaries[group]);
+	});
+
+	// a group may have been split between workers
+	for (size_t i = 0; i < m_BoidGroups.size(); i++)
+	{
+		IntegrationSummary summary;
+
+		for (size_t j = 0; j < m_Scratch.size(); j++)
+		{
+			summary.merge(m_Scratch[j].groupSummaries[i]);
+		}
+
+		m_BoidGroups[i].applySummary(summary);
+	}
+}
+
+void BoidSystem::swapBuffers()
+{
+	for (size_t i = 0; i < m_BoidGroups.size(); i++)
+	{
+		m_BoidGroups[i].swapBuffers();
+	}
+}
+
+void BoidSystem::prepareInstances(std::vector<BoidInstance>& instances, float interpolation)
+{
+	updateGroupOffsets();
+	instances.resize(m_GroupOffsets.back());
+
+	BoidInstance* data = instances.data();
+	runGroups([this, data, interpolation](size_t group, size_t begin, size_t end, size_t /*worker*/)
+	{
+		m_BoidGroups[group].prepareInstances(begin, end, interpolation, data + m_GroupOffsets[group]);
+	});
+
+	for (size_t i = 0; i < m_BoidGroups.size(); i++)
+	{
+		m_BoidGroups[i].removeDespawnedInstances(data + m_GroupOffsets[i]);
+	}
+}
+
+const std::vector<size_t>& BoidSystem::getGroupOffsets() const
+{
+	return m_GroupOffsets;
+}
+
+void BoidSystem::postChange(const ParameterChange& change)
+{
+	std::lock_guard<std::mutex> lock(m_ChangeMutex);
+
+	m_PostedChanges.push_back(change);
+}
+
+void BoidSystem::applyChange(const ParameterChange& change)
+{
+	if (change.group >= m_BoidGroups.size())
+	{
+		return;
+	}
+
+	BoidGroup& boidGroup = m_BoidGroups[change.group];
+	Vec2f size = boidGroup.getBoidSize();
+	Vec4f color = boidGroup.getBoidColor();
+
+	switch (change.parameter)
+	{
+	case GroupParameter::Cohesion:
+		boidGroup.setBoidCohesion(change.value);
+		break;
+	case GroupParameter::Separation:
+		boidGroup.setBoidSeparation(change.value);
+		break;
+	case GroupParameter::Alignment:
+		boidGroup.setBoidAlignment(change.value);
+		break;
+	case GroupParameter::Friendliness:
+		boidGroup.setBoidFriendliness(change.value);
+		break;
+	case GroupParameter::ViewDistance:
+		boidGroup.setBoidViewDistance(change.value);
+		break;
+	case GroupParameter::MinSeparationDistance:
+		boidGroup.setBoidMinSeparationDistance(change.value);
+		break;
+	case GroupParameter::MaxSpeed:
+		boidGroup.setBoidMaxSpeed(change.value);
+		break;
+	case GroupParameter::Count:
+		boidGroup.setCount(static_cast<size_t>(std::max(change.value, 0.0f)), m_Boundary);
+		break;
+	case GroupParameter::Width:
+		boidGroup.setBoidSize(Vec2f(change.value, size.y));
+		break;
+	case GroupParameter::Height:
+		boidGroup.setBoidSize(Vec2f(size.x, change.value));
+		break;
+	case GroupParameter::ColorR:
+		color.x = change.value;
+		boidGroup.setBoidColor(color);
+		break;
+	case GroupParameter::ColorG:
+		color.y = change.value;
+		boidGroup.setBoidColor(color);
+		break;
+	case GroupParameter::ColorB:
+		color.z = change.value;
+		boidGroup.setBoidColor(color);
+		break;
+	}
+}
+
+void BoidSystem::applyGroupChanges()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_ChangeMutex);
+
+		std::swap(m_PostedChanges, m_AppliedChanges);
+	}
+
+	for (size_t i = 0; i < m_AppliedChanges.size(); i++)
+	{
+		applyChange(m_AppliedChanges[i]);
+	}
+	m_AppliedChanges.clear();
+
+	// spawns and despawns must land before the grid is built, compacting moves boids around under its entries;
+	// kept neighbor lists refer to the old places
+	for (size_t i = 0; i < m_BoidGroups.size(); i++)
+	{
+		if (m_BoidGroups[i].compact())
+		{
+			m_NeighborsBuilt = false;
+		}
+
+		m_ParametersChanged |= m_BoidGroups[i].m_ParametersChanged;
+		m_BoidGroups[i].m_ParametersChanged = false;
+	}
+	updateGroupOffsets();
+
+	if (!m_ParametersChanged)
+	{
+		return;
+	}
+	m_ParametersChanged = false;
+
+	m_ViewDistances2.resize(m_BoidGroups.size());
+	m_SearchDistances2.resize(m_BoidGroups.size());
+	m_MinDistances2.resize(m_BoidGroups.size());
+	m_NearestCounts.resize(m_BoidGroups.size());
+	m_CellSize = 0.0f;
+
+	for (size_t i = 0; i < m_BoidGroups.size(); i++)
+	{
+		float viewDistance = *m_BoidGroups[i].getBoidViewDistance();
+		float searchDistance = viewDistance + m_NeighborSkin;
+		float minDistance = *m_BoidGroups[i].getBoidMinSeparationDistance();
+
+		m_ViewDistances2[i] = viewDistance * viewDistance;
+		m_MinDistances2[i] = minDistance * minDistance;
+		m_NearestCounts[i] = static_cast<uint32_t>(m_BoidGroups[i].getNearestCount());
+		m_SearchDistances2[i] = searchDistance * searchDistance;
+		m_CellSize = std::max(m_CellSize, searchDistance);
+	}
+
+	updateInteractions();
+}
+
+void BoidSystem::updateInteractions()
+{
+	size_t groupCount = m_BoidGroups.size();
+
+	m_Interactions.resize(groupCount * groupCount);
+	m_PairViewDistances2.resize(groupCount * groupCount);
+	m_PairSearchDistances2.resize(groupCount * groupCount);
+	m_PairSearchReaches.resize(groupCount * groupCount);
+	m_SteeringWeights.resize(2 * groupCount);
+	m_WeightedStrangers.resize(groupCount);
+
+	for (size_t i = 0; i < groupCount; i++)
+	{
+		for (size_t j = 0; j < groupCount; j++)
+		{
+			m_Interactions[i * groupCount + j] = getInteraction(i, j);
+		}
+	}
+
+	for (size_t i = 0; i < groupCount; i++)
+	{
+		const GroupInteraction* interactions = m_Interactions.data() + i * groupCount;
+		const GroupInteraction* strangerWeights = nullptr;
+		bool weighted = false;
+
+		for (size_t j = 0; j < groupCount; j++)
 		{
-			if (&boid == &boids[j])
-			{	
-				found = true;
+			bool ignored = interactions[j].isIgnored();
+
+			m_PairViewDistances2[i * groupCount + j] = ignored ? -1.0f : m_ViewDistances2[j];
+			m_PairSearchDistances2[i * groupCount + j] = ignored ? -1.0f : m_SearchDistances2[j];
+			m_PairSearchReaches[i * groupCount + j] = ignored ? -1.0f : std::sqrt(m_SearchDistances2[j]) * 1.001f;
+
+			if (j == i || ignored)
+			{
+				continue;
 			}
-			else
+
+			if (!strangerWeights)
 			{
-				float distance2 = Vec2f::length2(boid.getPosition() - boids[j].getPosition());
-				float viewDistance = *boidSystem.m_BoidGroups[i].getBoidViewDistance();
-				if (distance2 <= viewDistance * viewDistance)
-				{
-					boidAux.push_back(&boids[j]);
-				}
+				strangerWeights = &interactions[j];
+			}
+			else if (*strangerWeights != interactions[j])
+			{
+				weighted = true;
 			}
 		}
-		if (found)
-		{	
-			m_NearFriendlyBoids = boidAux;
-			found = false;
+
+		m_SteeringWeights[2 * i] = interactions[i];
+		m_SteeringWeights[2 * i + 1] = strangerWeights && !weighted ? *strangerWeights : GroupInteraction();
+		m_WeightedStrangers[i] = weighted ? 1 : 0;
+	}
+}
+
+void BoidSystem::updateReachableGroups()
+{
+	size_t groupCount = m_BoidGroups.size();
+
+	m_ReachableGroups.clear();
+	m_ReachableGroupOffsets.resize(groupCount + 1);
+	m_ReachableGroupOffsets[0] = 0;
+
+	for (size_t i = 0; i < groupCount; i++)
+	{
+		const Boundary2f& bounds = m_BoidGroups[i].getBounds();
+
+		for (size_t j = 0; j < groupCount; j++)
+		{
+			const Boundary2f& otherBounds = m_BoidGroups[j].getBounds();
+			float reach = m_PairSearchReaches[i * groupCount + j];
+
+			// written so that empty (inverted) boxes are out of reach and NaN boxes are not
+			if (reach < 0.0f ||
+				otherBounds.min.x - bounds.max.x > reach || bounds.min.x - otherBounds.max.x > reach ||
+				otherBounds.min.y - bounds.max.y > reach || bounds.min.y - otherBounds.max.y > reach)
+			{
+				continue;
+			}
+
+			ReachableGroup reachable;
+			reachable.bounds = otherBounds;
+			reachable.reach = reach;
+			m_ReachableGroups.push_back(reachable);
 		}
-		else
+
+		m_ReachableGroupOffsets[i + 1] = m_ReachableGroups.size();
+	}
+}
+
+void BoidSystem::updateGroupOffsets()
+{
+	m_GroupOffsets.resize(m_BoidGroups.size() + 1);
+	m_GroupOffsets[0] = 0;
+
+	for (size_t i = 0; i < m_BoidGroups.size(); i++)
+	{
+		m_GroupOffsets[i + 1] = m_GroupOffsets[i] + m_BoidGroups[i].getBoids().size();
+	}
+}
+
+void BoidSystem::runGroups(const std::function<void(size_t group, size_t begin, size_t end, size_t worker)>& task)
+{
+	m_ThreadPool.run(m_GroupOffsets.back(), [this, &task](size_t begin, size_t end, size_t worker)
+	{
+		size_t group = std::upper_bound(m_GroupOffsets.begin(), m_GroupOffsets.end(), begin) - m_GroupOffsets.begin() - 1;
+
+		for (; begin < end; group++)
 		{
-			for (size_t j = 0; j < boidAux.size(); j++)
+			size_t groupEnd = std::min(end, m_GroupOffsets[group + 1]);
+
+			if (begin < groupEnd)
 			{
-				m_NearStrangerBoids.push_back(boidAux[j]);
+				task(group, begin - m_GroupOffsets[group], groupEnd - m_GroupOffsets[group], worker);
 			}
+
+			begin = groupEnd;
+		}
+	});
+}
+
+size_t BoidSystem::getThreadCount() const
+{
+	return m_ThreadPool.getThreadCount();
+}
+
+void BoidSystem::setThreadCount(size_t threadCount)
+{
+	m_ThreadPool.setThreadCount(threadCount);
+	m_Scratch.resize(m_ThreadPool.getThreadCount());
+}
+
+void BoidSystem::setBoidBoundaryRepel(const Vec2f& v)
+{
+	m_BoundaryRepel = v;
+}
+
+CellOrder BoidSystem::getCellOrder() const
+{
+	return m_Grid.getCellOrder();
+}
+
+void BoidSystem::setCellOrder(CellOrder order)
+{
+	m_Grid.setCellOrder(order);
+}
+
+float BoidSystem::getNeighborSkin() const
+{
+	return m_NeighborSkin;
+}
+
+void BoidSystem::setNeighborSkin(float skin)
+{
+	m_NeighborSkin = std::max(skin, 0.0f);
+	m_NeighborsBuilt = false;
+	m_ParametersChanged = true;
+}
+
+bool BoidSystem::isPairwise() const
+{
+	return m_Pairwise;
+}
+
+void BoidSystem::setPairwise(bool value)
+{
+	m_Pairwise = value;
+	m_NeighborsBuilt = false;
+}
+
+bool BoidSystem::isMeanField() const
+{
+	return m_MeanField;
+}
+
+void BoidSystem::setMeanField(bool value)
+{
+	m_MeanField = value;
+	m_NeighborsBuilt = false;
+}
+
+float BoidSystem::getMeanFieldError() const
+{
+	return m_MeanFieldError;
+}
+
+void BoidSystem::setMeanFieldError(float error)
+{
+	m_MeanFieldError = std::max(error, 0.0f);
+}
+
+SimdLevel BoidSystem::getSimdLevel() const
+{
+	return m_KernelOptions.simdLevel;
+}
+
+void BoidSystem::setSimdLevel(SimdLevel level)
+{
+	m_KernelOptions.simdLevel = std::min(level, detectSimdLevel());
+}
+
+bool BoidSystem::isFastReciprocal() const
+{
+	return m_KernelOptions.fastReciprocal;
+}
+
+void BoidSystem::setFastReciprocal(bool value)
+{
+	m_KernelOptions.fastReciprocal = value;
+}
+
+GroupInteraction BoidSystem::getInteraction(size_t group, size_t otherGroup) const
+{
+	for (size_t i = 0; i < m_InteractionOverrides.size(); i++)
+	{
+		if (m_InteractionOverrides[i].group == group && m_InteractionOverrides[i].otherGroup == otherGroup)
+		{
+			return m_InteractionOverrides[i].interaction;
+		}
+	}
+
+	// the friendly boids weigh 1, the strangers the friendliness, and separation the inverse of that up to 2
+	float weight = group == otherGroup ? 1.0f : *m_BoidGroups[group].getFriendliness();
+
+	return GroupInteraction(weight, weight, std::min(1.0f / (weight + 0.000001f), 2.0f));
+}
+
+void BoidSystem::setInteraction(size_t group, size_t otherGroup, const GroupInteraction& interaction)
+{
+	resetInteraction(group, otherGroup);
+
+	InteractionOverride override;
+	override.group = group;
+	override.otherGroup = otherGroup;
+	override.interaction = interaction;
+	m_InteractionOverrides.push_back(override);
+	m_ParametersChanged = true;
+}
+
+void BoidSystem::resetInteraction(size_t group, size_t otherGroup)
+{
+	m_ParametersChanged = true;
+
+	for (size_t i = 0; i < m_InteractionOverrides.size(); i++)
+	{
+		if (m_InteractionOverrides[i].group == group && m_InteractionOverrides[i].otherGroup == otherGroup)
+		{
+			m_InteractionOverrides.erase(m_InteractionOverrides.begin() + i);
+			return;
 		}
-		boidAux.clear();
 	}
 }
 
-std::vector<Boid*>& BoidSystem::getNearFriendlyBoids()
+bool BoidSystem::isReordering() const
+{
+	return m_Reordering;
+}
+
+void BoidSystem::setReordering(bool value)
+{
+	m_Reordering = value;
+}
+
+BoidGroup* BoidSystem::addGroup()
+{
+	if (m_BoidGroups.size() == MAX_GROUPS)
+	{
+		return nullptr;
+	}
+
+	setCount(m_BoidGroups.size() + 1);
+
+	return &m_BoidGroups.back();
+}
+
+BoidGroup* BoidSystem::addGroup(size_t count)
+{
+	if (m_BoidGroups.size() == MAX_GROUPS)
+	{
+		return nullptr;
+	}
+
+	m_Countf += 1.0f;
+	m_ParametersChanged = true;
+
+	m_BoidGroups.push_back(BoidGroup(count, m_Boundary));
+
+	return &m_BoidGroups.back();
+}
+
+void BoidSystem::setBoidBoundary(const Boundary2f& bounds)
 {
-	return m_NearFriendlyBoids;
+	m_Boundary = bounds;
 }
 
-std::vector<Boid*>& BoidSystem::getNearStrangerBoids()
+void BoidSystem::findNearBoids(size_t boid, std::vector<uint32_t>& friendlyBoids, std::vector<uint32_t>& strangerBoids) const
 {
-	return m_NearStrangerBoids;
+	const SpatialGrid& grid = m_Grid;
+	const float* x = grid.getX();
+	const float* y = grid.getY();
+	const GroupId* groups = grid.getGroups();
+
+	uint32_t entry = grid.getEntry(boid);
+	GroupId group = groups[entry];
+	const float* searchDistances2 = m_PairSearchDistances2.data() + group * m_BoidGroups.size();
+	Vec2f position(x[entry], y[entry]);
+
+	int column = grid.getColumn(position.x);
+	int row = grid.getRow(position.y);
+	int minColumn = std::max(column - 1, 0);
+	int maxColumn = std::min(column + 1, grid.getColumns() - 1);
+	int minRow = std::max(row - 1, 0);
+	int maxRow = std::min(row + 1, grid.getRows() - 1);
+
+	// every boid in range lies in the search square around the boid and in the box of its group; the cells that
+	// cover none of these squares clipped to the boxes are left out. The cells are as large as the largest
+	// search distance, a group that sees less or whose box ends nearby needs fewer of them.
+	Vec2f reachMin(std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
+	Vec2f reachMax(-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max());
+
+	for (size_t i = m_ReachableGroupOffsets[group]; i < m_ReachableGroupOffsets[group + 1]; i++)
+	{
+		const Boundary2f& bounds = m_ReachableGroups[i].bounds;
+		float reach = m_ReachableGroups[i].reach;
+		float minX = std::max(position.x - reach, bounds.min.x);
+		float minY = std::max(position.y - reach, bounds.min.y);
+		float maxX = std::min(position.x + reach, bounds.max.x);
+		float maxY = std::min(position.y + reach, bounds.max.y);
+
+		if (minX > maxX || minY > maxY)
+		{
+			continue;
+		}
+
+		reachMin.x = std::min(reachMin.x, minX);
+		reachMin.y = std::min(reachMin.y, minY);
+		reachMax.x = std::max(reachMax.x, maxX);
+		reachMax.y = std::max(reachMax.y, maxY);
+	}
+
+	if (reachMin.x > reachMax.x)
+	{
+		return;
+	}
+
+	minColumn = std::max(minColumn, grid.getColumn(reachMin.x));
+	maxColumn = std::min(maxColumn, grid.getColumn(reachMax.x));
+	minRow = std::max(minRow, grid.getRow(reachMin.y));
+	maxRow = std::min(maxRow, grid.getRow(reachMax.y));
+
+	// the filter writes every boid in range to the end of the friendly list, then the strangers move out
+	// and the friendly boids close up behind them
+	auto scan = [&](uint32_t begin, uint32_t end)
+	{
+		size_t first = friendlyBoids.size();
+		friendlyBoids.resize(first + (end - begin) + SIMD_WIDTH);
+
+		uint32_t* candidates = friendlyBoids.data() + first;
+		size_t candidateCount = filterNear(m_KernelOptions.simdLevel, x, y, groups, searchDistances2, position.x, position.y,
+			begin, end, candidates);
+		size_t friendlyCount = 0;
+
+		for (size_t j = 0; j < candidateCount; j++)
+		{
+			uint32_t i = candidates[j];
+
+			if (i == entry)
+			{
+				continue;
+			}
+
+			if (groups[i] == group)
+			{
+				candidates[friendlyCount++] = i;
+			}
+			else
+			{
+				strangerBoids.push_back(i);
+			}
+		}
+
+		friendlyBoids.resize(first + friendlyCount);
+	};
+
+	for (int cellRow = minRow; cellRow <= maxRow; cellRow++)
+	{
+		// neighboring cells that follow each other in memory are scanned as one range,
+		// in row-major order that is the whole row of the block
+		uint32_t begin = grid.cellBegin(minColumn, cellRow);
+		uint32_t end = grid.cellEnd(minColumn, cellRow);
+
+		for (int cellColumn = minColumn + 1; cellColumn <= maxColumn; cellColumn++)
+		{
+			uint32_t cellBegin = grid.cellBegin(cellColumn, cellRow);
+
+			if (cellBegin != end)
+			{
+				scan(begin, end);
+				begin = cellBegin;
+			}
+
+			end = grid.cellEnd(cellColumn, cellRow);
+		}
+
+		scan(begin, end);
+	}
 }
 
 std::vector<BoidGroup>& BoidSystem::getGroups()
 {
 	return m_BoidGroups;
+}
+
+const SpatialGrid& BoidSystem::getGrid() const
+{
+	return m_Grid;
+}
+
+const NeighborTable& BoidSystem::getNeighbors() const
+{
+	return m_Neighbors;
+}
+
+size_t BoidSystem::getNeighborCount() const
+{
+	return m_Pairwise || m_MeanField ? m_SummedNeighborCount : m_Neighbors.getNeighborCount();
+}
+
+const UpdateStats& BoidSystem::getUpdateStats() const
+{
+	return m_UpdateStats;
+}
+
+void BoidSystem::findNearestBoids(size_t boid, size_t count, std::vector<std::pair<float, uint32_t>>& nearestBoids,
+	std::vector<uint32_t>& friendlyBoids, std::vector<uint32_t>& strangerBoids) const
+{
+	const SpatialGrid& grid = m_Grid;
+	const float* x = grid.getX();
+	const float* y = grid.getY();
+	const GroupId* groups = grid.getGroups();
+
+	uint32_t entry = grid.getEntry(boid);
+	GroupId group = groups[entry];
+	const float* searchDistances2 = m_PairSearchDistances2.data() + group * m_BoidGroups.size();
+	Vec2f position(x[entry], y[entry]);
+
+	int column = grid.getColumn(position.x);
+	int row = grid.getRow(position.y);
+	int columns = grid.getColumns();
+	int rows = grid.getRows();
+
+	// ties are broken by the entry, so the same boids are chosen whatever order the cells are scanned in
+	nearestBoids.clear();
+
+	auto scan = [&](int cellColumn, int cellRow)
+	{
+		if (cellColumn < 0 || cellColumn >= columns || cellRow < 0 || cellRow >= rows)
+		{
+			return;
+		}
+
+		uint32_t end = grid.cellEnd(cellColumn, cellRow);
+
+		for (uint32_t i = grid.cellBegin(cellColumn, cellRow); i < end; i++)
+		{
+			// ignored groups are the only ones with a negative distance
+			if (i == entry || searchDistances2[groups[i]] < 0.0f)
+			{
+				continue;
+			}
+
+			float dx = position.x - x[i];
+			float dy = position.y - y[i];
+			std::pair<float, uint32_t> candidate(dx * dx + dy * dy, i);
+
+			if (nearestBoids.size() < count)
+			{
+				nearestBoids.push_back(candidate);
+				std::push_heap(nearestBoids.begin(), nearestBoids.end());
+			}
+			else if (candidate < nearestBoids.front())
+			{
+				replaceFarthest(nearestBoids, candidate);
+			}
+		}
+	};
+
+	// rings of cells around the boid's cell; after ring r every boid closer than r cells plus the distance
+	// from the boid to the border of its own cell has been seen
+	float cellSize = grid.getCellSize();
+	Vec2f cellMin = grid.getOrigin() + Vec2f(column * cellSize, row * cellSize);
+	float margin = std::min(std::min(position.x - cellMin.x, cellMin.x + cellSize - position.x),
+		std::min(position.y - cellMin.y, cellMin.y + cellSize - position.y));
+	margin = std::max(margin, 0.0f);
+
+	int maxRing = std::max(std::max(column, columns - 1 - column), std::max(row, rows - 1 - row));
+
+	for (int ring = 0; ring <= maxRing; ring++)
+	{
+		if (ring == 0)
+		{
+			scan(column, row);
+		}
+		else
+		{
+			for (int cellColumn = std::max(column - ring, 0); cellColumn <= std::min(column + ring, columns - 1); cellColumn++)
+			{
+				scan(cellColumn, row - ring);
+				scan(cellColumn, row + ring);
+			}
+			for (int cellRow = std::max(row - ring + 1, 0); cellRow <= std::min(row + ring - 1, rows - 1); cellRow++)
+			{
+				scan(column - ring, cellRow);
+				scan(column + ring, cellRow);
+			}
+		}
+
+		float reach = ring * cellSize + margin;
+
+		if (nearestBoids.size() == count && nearestBoids.front().first <= reach * reach)
+		{
+			break;
+		}
+	}
+
+	std::sort_heap(nearestBoids.begin(), nearestBoids.end());
+
+	for (size_t i = 0; i < nearestBoids.size(); i++)
+	{
+		uint32_t other = nearestBoids[i].second;
+
+		if (groups[other] == group)
+		{
+			friendlyBoids.push_back(other);
+		}
+		else
+		{
+			strangerBoids.push_back(other);
+		}
+	}
+}
+
+/************************************************************************************************************
+*											NeighborScratch
+*************************************************************************************************************/
+
+NeighborScratch::NeighborScratch()
+{
+	neighborCount = 0;
+	maxNeighbors = 0;
+	maxDisplacement2 = 0.0f;
+}
+
+/************************************************************************************************************
+*											UpdateStats
+*************************************************************************************************************/
+
+UpdateStats::UpdateStats()
+{
+	reset();
+}
+
+void UpdateStats::reset()
+{
+	neighborSeconds = 0.0;
+	steeringSeconds = 0.0;
+	integrationSeconds = 0.0;
+
+	boidCount = 0;
+	neighborCount = 0;
+	maxNeighbors = 0;
+	neighborsRebuilt = true;
 }
\ No newline at end of file
@@ -1,8 +1,69 @@
 #pragma once
 
-#include "../utils/utils.h"
+#include "../utils/vecmath.h"
+#include "../utils/aligned.h"
+#include "../utils/threadpool.h"
+#include "grid.h"
+#include "kernels.h"
+#include "neighbors.h"
+#include <mutex>
+#include <utility>
 #include <vector>
-#include <GL/freeglut.h>
+
+/************************************************************************************************************
+* Weights of the cohesion, alignment and separation of a boid towards the boids of one group.
+*************************************************************************************************************/
+struct GroupInteraction
+{
+	GroupInteraction();
+	GroupInteraction(float cohesion, float alignment, float separation);
+
+	// a boid ignores the groups it has all weights 0 for, they are never gathered as neighbors
+	bool isIgnored() const;
+
+	bool operator==(const GroupInteraction& other) const;
+	bool operator!=(const GroupInteraction& other) const;
+
+	float cohesion;
+	float alignment;
+	float separation;
+};
+
+/************************************************************************************************************
+* Sums gathered in a single pass over a set of neighbors, from which cohesion, separation and alignment
+* are all computed.
+*************************************************************************************************************/
+struct SteeringSums
+{
+	SteeringSums();
+
+	void accumulate(const KernelOptions& options, const Vec2f& position, float minSeparationDistance, const SpatialGrid& grid,
+		const NeighborSpan& nearBoids, const float* viewDistances2);
+	// weighs every neighbor by the interaction with its group
+	void accumulate(const Vec2f& position, float minSeparationDistance, const SpatialGrid& grid, const NeighborSpan& nearBoids,
+		const float* viewDistances2, const GroupInteraction* interactions);
+	// adds one neighbor at (x, y) moving at (vx, vy), (dx, dy) points from it to the steering boid
+	void add(float x, float y, float vx, float vy, float dx, float dy, float distance2, float minDistance2);
+	void add(float x, float y, float vx, float vy, float dx, float dy, float distance2, float minDistance2,
+		const GroupInteraction& interaction);
+	// adds every boid of a cell aggregate, separating from their centroid at (dx, dy) from the steering boid
+	void add(const CellAggregate& aggregate, float dx, float dy, float distance2, float minDistance2);
+	void add(const CellAggregate& aggregate, float dx, float dy, float distance2, float minDistance2,
+		const GroupInteraction& interaction);
+
+	float positionX;
+	float positionY;
+	float separationX;
+	float separationY;
+	float velocityX;
+	float velocityY;
+	size_t count;
+
+	// set once a boid is added with weights: the position, separation and velocity sums are then weighted
+	// and cohesionWeight sums the cohesion weights
+	bool weighted;
+	float cohesionWeight;
+};
 
 class Boid
 {
@@ -15,21 +76,133 @@ public:
 	void setPosition(const Vec2f& v);
 	void setVelocity(const Vec2f& v);
 
-	void cohere(float cohesion, const std::vector<Boid*>& nearBoids, float friendliness);
-	void separate(float separation, float minSeparationDistance, const std::vector<Boid*>& nearBoids, float friendliness);
-	void align(float alignment, const std::vector<Boid*>& nearBoids, float friendliness);
+	// weights[0] applies to the friendly boids and weights[1] to the strangers; when strangerInteractions is set
+	// each stranger is weighted by the interaction with its group instead
+	void steer(float cohesion, float separation, float alignment, float minSeparationDistance,
+		const SpatialGrid& grid, const NeighborSpan& friendlyBoids, const NeighborSpan& strangerBoids,
+		const float* viewDistances2, const GroupInteraction* weights, const GroupInteraction* strangerInteractions,
+		const KernelOptions& options);
+	// sums[0] holds the friendly boids, sums[1] the strangers
+	void steer(float cohesion, float separation, float alignment, const SteeringSums* sums, const GroupInteraction* weights);
 	void constrainBounds(const Boundary2f& bounds, const Vec2f& boundaryRepel);
 	void constrainSpeed(float maxSpeed);
 
 	void update(float dt);
 
-	void draw(GLuint modelList, const Vec2f& size, const Vec4f& color) const;
-
 private:
 	Vec2f m_Position;
 	Vec2f m_Velocity;
 };
 
+/************************************************************************************************************
+* Boid state stored as separate contiguous x/y arrays (structure of arrays).
+* The arrays are aligned and padded with zeros up to a multiple of SIMD_WIDTH.
+*************************************************************************************************************/
+class BoidArray
+{
+public:
+	BoidArray();
+
+	size_t size() const;
+	bool empty() const;
+
+	Boid operator[](size_t index) const;
+	Vec2f getPosition(size_t index) const;
+	Vec2f getVelocity(size_t index) const;
+
+	void set(size_t index, const Boid& boid);
+	void setPosition(size_t index, const Vec2f& v);
+	void setVelocity(size_t index, const Vec2f& v);
+
+	void resize(size_t count);
+	void reserve(size_t count);
+	void clear();
+	void push_back(const Vec2f& position, const Vec2f& velocity);
+
+	float* getX();
+	float* getY();
+	float* getVX();
+	float* getVY();
+	const float* getX() const;
+	const float* getY() const;
+	const float* getVX() const;
+	const float* getVY() const;
+
+private:
+	size_t m_Size;
+
+	AlignedVector<float> m_X;
+	AlignedVector<float> m_Y;
+	AlignedVector<float> m_VX;
+	AlignedVector<float> m_VY;
+};
+
+/************************************************************************************************************
+* Stable reference to a boid of a BoidGroup, valid however the boid is moved around in the arrays.
+* A despawned boid's slot is reused by a later spawn under the next generation, so old handles stay invalid.
+* Live boids have an odd generation, a default handle is never valid.
+*************************************************************************************************************/
+struct BoidHandle
+{
+	BoidHandle();
+	BoidHandle(uint32_t slot, uint32_t generation);
+
+	bool operator==(const BoidHandle& other) const;
+	bool operator!=(const BoidHandle& other) const;
+
+	uint32_t slot;
+	uint32_t generation;
+};
+
+/************************************************************************************************************
+* Per-instance data of one boid for instanced drawing: position and unit heading.
+*************************************************************************************************************/
+struct BoidInstance
+{
+	float x;
+	float y;
+	float directionX;
+	float directionY;
+};
+
+/************************************************************************************************************
+* Per-worker state of the neighbor search and the integration. Every worker thread owns one.
+*************************************************************************************************************/
+struct NeighborScratch
+{
+	NeighborScratch();
+
+	std::vector<uint32_t> strangerBoids;
+	// boxes and sums of the boids this worker integrated, one per group
+	std::vector<IntegrationSummary> groupSummaries;
+	// max-heap of (distance2, entry) of the nearest boids found so far
+	std::vector<std::pair<float, uint32_t>> nearestBoids;
+	size_t neighborCount;
+	size_t maxNeighbors;
+	float maxDisplacement2;
+};
+
+/************************************************************************************************************
+* Stage timings and neighbor counts of one BoidSystem::update.
+* Every stage is a separate pass over all boids, the times are wall times. The neighbor search includes
+* the grid rebuild.
+*************************************************************************************************************/
+struct UpdateStats
+{
+	UpdateStats();
+
+	void reset();
+
+	double neighborSeconds;
+	double steeringSeconds;
+	double integrationSeconds;
+
+	size_t boidCount;
+	size_t neighborCount;
+	size_t maxNeighbors;
+	bool neighborsRebuilt;
+};
+
 class BoidSystem;
 
 class BoidGroup
@@ -38,50 +211,132 @@ public:
 	BoidGroup();
 	BoidGroup(size_t count, const Boundary2f& bounds);
 
+	// the count, and the distances and friendliness BoidSystem derives its tables from, only change through the
+	// setters or BoidSystem::postChange; values written through these pointers are not noticed
 	Vec2f& getBoidSize();
 	float* getCount();
 	float* getBoidCohesion();
 	float* getBoidSeparation();
 	float* getBoidAlignment();
 	float* getFriendliness();
+	const float* getFriendliness() const;
 	float* getBoidViewDistance();
+	const float* getBoidViewDistance() const;
 	float* getBoidMinSeparationDistance();
 	float* getBoidMaxSpeed();
-	GLuint getBoidModel();
+	size_t getNearestCount() const;
 	
 	Vec4f& getBoidColor();
 
+	// averages over the live boids, summed by integrate and kept up to date by spawn and despawn
 	Vec2f getAveragePosition() const;
 	Vec2f getAverageVelocity() const;
-
-	std::vector <Boid>& getBoids();
-
+	// box around the positions of the boids, inverted (min > max) while the group is empty;
+	// despawned boids stay in it until the next integration
+	const Boundary2f& getBounds() const;
+	// recomputes the bounds and averages after the boids were moved outside of integrate
+	void updateSummary();
+
+	BoidArray& getBoids();
+	const BoidArray& getBoids() const;
+
+	// getBoids() still holds the boids despawned since the last compact, this leaves them out
+	size_t getLiveCount() const;
+	BoidHandle getBoidHandle(size_t index) const;
+	bool isAlive(const BoidHandle& handle) const;
+	// index in getBoids() of a live boid
+	size_t getBoidIndex(const BoidHandle& handle) const;
+
+	BoidHandle spawn(const Vec2f& position, const Vec2f& velocity);
+	// the boid is invalidated at once but only leaves the arrays with the next compact, false if it was not alive
+	bool despawn(const BoidHandle& handle);
+	// moves the last boids into the places of the despawned ones, true if any boid was spawned or despawned since
+	// the last compact
+	bool compact();
+
+	// spawns or despawns boids until count are alive, despawning the highest slots first so the boids spawned
+	// first are kept
 	void setCount(size_t count, const Boundary2f&);
 	void setBoidSize(const Vec2f& v);
 	void setBoidCohesion(float cohesion);
 	void setBoidSeparation(float separation);
 	void setBoidAlignment(float alignment);
+	// weighs the cohesion and alignment towards the other groups, and the separation by its inverse,
+	// for every group without an interaction set in BoidSystem
 	void setBoidFriendliness(float friendliness);
 	void setBoidViewDistance(float viewDistance);
 	void setBoidMinSeparationDistance(float minDistance);
 
 	void setBoidMaxSpeed(float maxSpeed);
+	// 0 steers by every boid within the view distance, otherwise by the count nearest boids however far;
+	// while any group steers by its nearest boids the neighbor lists are rebuilt every tick, whatever the skin
+	void setNearestCount(size_t count);
 
 	void setBoidColor(const Vec4f& color);
 
-	void update(float dt, BoidSystem& boidSystem);
+	void steer(size_t begin, size_t end, size_t firstBoid, const SpatialGrid& grid, const NeighborTable& neighbors,
+		const float* viewDistances2, const GroupInteraction* weights, const GroupInteraction* strangerInteractions,
+		const KernelOptions& options);
+	void steer(size_t begin, size_t end, size_t firstBoid, const SpatialGrid& grid, const SteeringSums* pairSums,
+		const GroupInteraction* weights);
+	// adds the integrated boids to summary
+	void integrate(size_t begin, size_t end, float dt, const Boundary2f& bounds, const Vec2f& boundaryRepel, SimdLevel level,
+		IntegrationSummary& summary);
+	void swapBuffers();
+
+	void reorder(size_t begin, size_t end, const uint32_t* order, size_t firstBoid);
+	void swapOrder();
 
-	void draw() const;
+	// places the boids at interpolation between their positions before the last tick (0) and now (1)
+	void prepareInstances(size_t begin, size_t end, float interpolation, BoidInstance* instances) const;
+	// moves the instances of the live boids into the first getLiveCount() places, like compact moves the boids
+	void removeDespawnedInstances(BoidInstance* instances);
 
-	static void setModelList(GLuint drawList);
-	static void initModels();
+	static const Vec2f* getModelVertices();
+	static size_t getModelVertexCount();
 
 private:
-	std::vector<Boid> m_Boids;
+	// fills m_DespawnedIndices with the indices of the despawned boids, highest first
+	void updateDespawnedIndices();
+	// called by BoidSystem::integrate with the merged summaries of the chunks
+	void applySummary(const IntegrationSummary& summary);
+
+private:
+	// m_Boids holds the state of the current tick and is only read during an update,
+	// the next tick is written into m_BackBoids
+	BoidArray m_Boids;
+	BoidArray m_BackBoids;
+
+	// boids move around in m_Boids when BoidSystem reorders them or compact fills a hole, their slots do not:
+	// m_Ids maps an index to the slot of the boid there and m_Indices maps a slot back to its index.
+	// Slots of compacted boids go on m_FreeSlots, m_SlotEnd is past the highest slot that may be alive.
+	std::vector<uint32_t> m_Ids;
+	std::vector<uint32_t> m_BackIds;
+	std::vector<uint32_t> m_Indices;
+	std::vector<uint32_t> m_Generations;
+	std::vector<uint32_t> m_FreeSlots;
+	std::vector<uint32_t> m_Despawned;
+	std::vector<uint32_t> m_DespawnedIndices;
+	size_t m_SlotEnd;
+	bool m_Changed;
+
+	// set by the setters of the parameters BoidSystem derives its distances and interactions from,
+	// cleared by BoidSystem once it has recomputed them
+	bool m_ParametersChanged;
+	friend class BoidSystem;
+
+	// after swapBuffers m_BackBoids holds the boids as they were before the tick, in the same order, until a spawn
+	// or a compact moves them; boids moved through getBoids are drawn from where they were for one frame
+	bool m_HasPrevious;
 
 	float m_Countf;
 	Vec2f m_Size;
 
+	// set by BoidSystem::integrate from the summaries of the chunks, and by updateSummary
+	Boundary2f m_Bounds;
+	Vec2f m_PositionSum;
+	Vec2f m_VelocitySum;
+
 	float m_Cohesion;   //[0, 1]
 	float m_Separation; //[0, 1]
 	float m_Alignment;  //[0, 1]
@@ -90,9 +345,43 @@ private:
 	float m_ViewDistance;
 	float m_MinSeparationDistance;
 	float m_MaxSpeed;
+	size_t m_NearestCount;
 	
 	Vec4f m_Color;
-	static GLuint m_ModelList;
+	static const Vec2f m_ModelVertices[3];
+};
+
+/************************************************************************************************************
+* Parameters of a BoidGroup that can be changed through BoidSystem::postChange.
+*************************************************************************************************************/
+enum class GroupParameter
+{
+	Cohesion,
+	Separation,
+	Alignment,
+	Friendliness,
+	ViewDistance,
+	MinSeparationDistance,
+	MaxSpeed,
+	Count,
+	Width,
+	Height,
+	ColorR,
+	ColorG,
+	ColorB
+};
+
+/************************************************************************************************************
+* A new value for one parameter of one group, applied by the BoidSystem at the start of its next tick.
+*************************************************************************************************************/
+struct ParameterChange
+{
+	ParameterChange();
+	ParameterChange(size_t group, GroupParameter parameter, float value);
+
+	size_t group;
+	GroupParameter parameter;
+	float value;
 };
 
 class BoidSystem
@@ -103,35 +392,181 @@ public:
 
 	float* getCount();
 	Boundary2f* getBoidBoundary();
+	const Boundary2f* getBoidBoundary() const;
 	Vec2f* getBoidBoundaryRepel();
+	const Vec2f* getBoidBoundaryRepel() const;
 	BoidGroup& getGroup(size_t index);
 	std::vector<BoidGroup>& getGroups();
 
+	// at most MAX_GROUPS
 	void setCount(size_t count);
 	void setBoidBoundary(const Boundary2f& bounds);
 	void setBoidBoundaryRepel(const Vec2f& v);
 
-	BoidGroup& addGroup();
-	BoidGroup& addGroup(size_t count);
-
-	void check(const MouseStats& mouseStats);
+	CellOrder getCellOrder() const;
+	void setCellOrder(CellOrder order);
+	bool isReordering() const;
+	void setReordering(bool value);
+	float getNeighborSkin() const;
+	void setNeighborSkin(float skin);
+	bool isPairwise() const;
+	void setPairwise(bool value);
+	bool isMeanField() const;
+	void setMeanField(bool value);
+	float getMeanFieldError() const;
+	void setMeanFieldError(float error);
+	SimdLevel getSimdLevel() const;
+	// levels above the one the processor supports fall back to that one
+	void setSimdLevel(SimdLevel level);
+	bool isFastReciprocal() const;
+	void setFastReciprocal(bool value);
+
+	// how the boids of group weigh the boids of otherGroup, which may be the same group; without a set interaction
+	// the weights follow the friendliness of group. Pairs with all weights 0 are skipped by the neighbor search.
+	GroupInteraction getInteraction(size_t group, size_t otherGroup) const;
+	void setInteraction(size_t group, size_t otherGroup, const GroupInteraction& interaction);
+	void resetInteraction(size_t group, size_t otherGroup);
+
+	// may be called from any thread; the changes are applied in order when the next tick starts, changes to groups
+	// that no longer exist are dropped
+	void postChange(const ParameterChange& change);
+
+	// nullptr once there are MAX_GROUPS groups
+	BoidGroup* addGroup();
+	BoidGroup* addGroup(size_t count);
 
 	void update(float dt);
 
-	void draw() const;
+	// the stages of update, in order; the grid and the neighbors are only rebuilt when refreshNeighbors fails
+	bool refreshNeighbors();
+	void rebuildGrid();
+	void reorderBoids();
+	void findNeighbors();
+	void accumulatePairs();
+	void accumulateMeanField();
+	void steer();
+	void integrate(float dt);
+	void swapBuffers();
+
+	// interpolation as in BoidGroup::prepareInstances, the window draws the time left over from its fixed steps.
+	// The boids of group g start at getGroupOffsets()[g], boids despawned since the last tick are left out:
+	// only the first getLiveCount() of them are drawn.
+	void prepareInstances(std::vector<BoidInstance>& instances, float interpolation);
+	const std::vector<size_t>& getGroupOffsets() const;
+
+	void findNearBoids(size_t boid, std::vector<uint32_t>& friendlyBoids, std::vector<uint32_t>& strangerBoids) const;
+	void findNearestBoids(size_t boid, size_t count, std::vector<std::pair<float, uint32_t>>& nearestBoids,
+		std::vector<uint32_t>& friendlyBoids, std::vector<uint32_t>& strangerBoids) const;
+
+	const SpatialGrid& getGrid() const;
+	const NeighborTable& getNeighbors() const;
+	size_t getNeighborCount() const;
+	const UpdateStats& getUpdateStats() const;
+
+	size_t getThreadCount() const;
+	void setThreadCount(size_t threadCount);
 
-	static void findNearBoids(const Boid& boid, BoidSystem& boidSystem);
-	static std::vector<Boid*>& getNearFriendlyBoids();
-	static std::vector<Boid*>& getNearStrangerBoids();
+private:
+	void applyChange(const ParameterChange& change);
+	void applyGroupChanges();
+	void updateInteractions();
+	void updateReachableGroups();
+	void accumulateRow(int row);
+	void accumulateCells(uint32_t entry, int reach, float maxViewDistance2, SteeringSums* sums) const;
+	void updateSummedStats();
+	void updateGroupOffsets();
+	void runGroups(const std::function<void(size_t group, size_t begin, size_t end, size_t worker)>& task);
 
 private:
 	std::vector<BoidGroup> m_BoidGroups;
 
 	float m_Countf;
 
+	// changes posted since the last tick, swapped with m_AppliedChanges under the lock so posting never waits
+	// for a tick. The distances, cell size and interaction table below are only recomputed once a change of
+	// the groups or of the settings they depend on sets m_ParametersChanged.
+	std::mutex m_ChangeMutex;
+	std::vector<ParameterChange> m_PostedChanges;
+	std::vector<ParameterChange> m_AppliedChanges;
+	bool m_ParametersChanged;
+
 	Boundary2f m_Boundary;
 	Vec2f m_BoundaryRepel;
 
-	static std::vector<Boid*> m_NearFriendlyBoids;
-	static std::vector<Boid*> m_NearStrangerBoids;
+	SpatialGrid m_Grid;
+	NeighborTable m_Neighbors;
+
+	// when set, boids are sorted into the cell order of the grid every tick
+	bool m_Reordering;
+	std::vector<uint32_t> m_Order;
+	std::vector<float> m_ViewDistances2;
+	std::vector<float> m_SearchDistances2;
+	std::vector<float> m_MinDistances2;
+	std::vector<uint32_t> m_NearestCounts;
+	float m_CellSize;
+
+	// with a skin the neighbor lists hold every boid within view distance + skin and are kept until some boid
+	// has moved more than half the skin since they were built; steering filters them by view distance again.
+	// Lists are never kept while a group steers by its nearest boids.
+	float m_NeighborSkin;
+	bool m_NeighborsBuilt;
+	std::vector<size_t> m_BuildGroupOffsets;
+	std::vector<float> m_BuildPairViewDistances2;
+	std::vector<uint32_t> m_BuildNearestCounts;
+	std::vector<float> m_BuildX;
+	std::vector<float> m_BuildY;
+
+	// pairwise, every pair of boids in neighboring cells is visited once and adds to the sums of both boids
+	// instead of each boid gathering its own neighbor list; m_EntrySums holds two sums per grid entry.
+	// Groups that steer by their nearest boids keep their lists.
+	bool m_Pairwise;
+	std::vector<SteeringSums> m_EntrySums;
+	size_t m_SummedNeighborCount;
+
+	// with the mean field, the grid is made m_MeanFieldDivisions times finer and a cell entirely within view
+	// is added as its aggregate once it is small enough as seen from the boid: cell size <= error * distance.
+	// The sums of cohesion and alignment stay exact, separation pushes away from the centroid of the cell.
+	bool m_MeanField;
+	float m_MeanFieldError;
+	static constexpr int m_MeanFieldDivisions = 4;
+
+	KernelOptions m_KernelOptions;
+
+	// row g of the interaction table holds how the boids of group g weigh the boids of every group and the
+	// squared distances they see them at, the view or search distance of that group or -1 for ignored groups.
+	// A group whose strangers that are not ignored all have the same weights steers by their plain sums like
+	// by the friendly ones, m_SteeringWeights then holds those weights after the friendly ones; the others are
+	// weighted boid by boid and steer with unit weights.
+	struct InteractionOverride
+	{
+		size_t group;
+		size_t otherGroup;
+		GroupInteraction interaction;
+	};
+	std::vector<InteractionOverride> m_InteractionOverrides;
+	std::vector<GroupInteraction> m_Interactions;
+	std::vector<float> m_PairViewDistances2;
+	std::vector<float> m_PairSearchDistances2;
+	std::vector<GroupInteraction> m_SteeringWeights;
+	std::vector<uint8_t> m_WeightedStrangers;
+
+	// the neighbor search skips the cells of its block that no group in reach can have a boid in. Group h is in
+	// reach of group g while their boxes are closer than the search distance; entries m_ReachableGroupOffsets[g]
+	// to m_ReachableGroupOffsets[g + 1] of m_ReachableGroups hold the box of each such h and that distance,
+	// unsquared and padded against rounding. m_PairSearchReaches holds those distances for every pair.
+	struct ReachableGroup
+	{
+		Boundary2f bounds;
+		float reach;
+	};
+	std::vector<float> m_PairSearchReaches;
+	std::vector<ReachableGroup> m_ReachableGroups;
+	std::vector<size_t> m_ReachableGroupOffsets;
+
+	std::vector<size_t> m_GroupOffsets;
+
+	ThreadPool m_ThreadPool;
+	std::vector<NeighborScratch> m_Scratch;
+
+	UpdateStats m_UpdateStats;
 };
\ No newline at end of file
@@ -0,0 +1,529 @@
+#include "grid.h"
+#include "boid.h"
+#include <algorithm>
+
+// calls function(group, begin, end) for the part of every group inside the global boid range [begin, end)
+template <typename Function>
+static void forEachGroupRange(const std::vector<size_t>& groupOffsets, size_t begin, size_t end, Function function)
+{
+	size_t group = std::upper_bound(groupOffsets.begin(), groupOffsets.end(), begin) - groupOffsets.begin() - 1;
+
+	for (; begin < end; group++)
+	{
+		size_t groupEnd = std::min(end, groupOffsets[group + 1]);
+
+		if (begin < groupEnd)
+		{
+			function(group, begin - groupOffsets[group], groupEnd - groupOffsets[group]);
+		}
+
+		begin = groupEnd;
+	}
+}
+
+static uint64_t mortonKey(uint32_t column, uint32_t row)
+{
+	uint64_t key = 0;
+
+	for (uint32_t bit = 0; bit < 16; bit++)
+	{
+		key |= static_cast<uint64_t>((column >> bit) & 1) << (2 * bit);
+		key |= static_cast<uint64_t>((row >> bit) & 1) << (2 * bit + 1);
+	}
+
+	return key;
+}
+
+// distance along the Hilbert curve that fills an n x n square, n a power of two
+static uint64_t hilbertKey(uint32_t n, uint32_t column, uint32_t row)
+{
+	uint64_t key = 0;
+
+	for (uint32_t s = n / 2; s > 0; s /= 2)
+	{
+		uint32_t rx = (column & s) ? 1 : 0;
+		uint32_t ry = (row & s) ? 1 : 0;
+
+		key += static_cast<uint64_t>(s) * s * ((3 * rx) ^ ry);
+
+		// rotate the quadrant so the curve continues where the previous one ended
+		if (ry == 0)
+		{
+			if (rx == 1)
+			{
+				column = n - 1 - column;
+				row = n - 1 - row;
+			}
+
+			std::swap(column, row);
+		}
+	}
+
+	return key;
+}
+
+CellAggregate::CellAggregate()
+{
+	positionX = 0.0f;
+	positionY = 0.0f;
+	velocityX = 0.0f;
+	velocityY = 0.0f;
+	count = 0;
+}
+
+SpatialGrid::SpatialGrid()
+{
+	m_CellSize = 1.0f;
+	m_Columns = 1;
+	m_Rows = 1;
+
+	m_CellOrder = CellOrder::RowMajor;
+	m_RankedOrder = CellOrder::RowMajor;
+	m_RankedColumns = 1;
+	m_RankedRows = 1;
+	m_CellRanks.assign(1, 0);
+
+	m_CellStart.assign(2, 0);
+
+	m_AggregateGroups = 0;
+}
+
+const Vec2f& SpatialGrid::getOrigin() const
+{
+	return m_Origin;
+}
+
+float SpatialGrid::getCellSize() const
+{
+	return m_CellSize;
+}
+
+int SpatialGrid::getColumns() const
+{
+	return m_Columns;
+}
+
+int SpatialGrid::getRows() const
+{
+	return m_Rows;
+}
+
+CellOrder SpatialGrid::getCellOrder() const
+{
+	return m_CellOrder;
+}
+
+void SpatialGrid::setCellOrder(CellOrder order)
+{
+	m_CellOrder = order;
+}
+
+int SpatialGrid::getColumn(float x) const
+{
+	float column = (x - m_Origin.x) / m_CellSize;
+
+	// also catches NaN positions
+	if (!(column >= 0.0f))
+	{
+		return 0;
+	}
+
+	if (column >= static_cast<float>(m_Columns))
+	{
+		return m_Columns - 1;
+	}
+
+	return static_cast<int>(column);
+}
+
+int SpatialGrid::getRow(float y) const
+{
+	float row = (y - m_Origin.y) / m_CellSize;
+
+	if (!(row >= 0.0f))
+	{
+		return 0;
+	}
+
+	if (row >= static_cast<float>(m_Rows))
+	{
+		return m_Rows - 1;
+	}
+
+	return static_cast<int>(row);
+}
+
+const CellAggregate* SpatialGrid::getAggregates(int column, int row) const
+{
+	return m_Aggregates.data() + m_CellRanks[row * m_Columns + column] * m_AggregateGroups;
+}
+
+uint32_t SpatialGrid::cellBegin(int column, int row) const
+{
+	return m_CellStart[m_CellRanks[row * m_Columns + column]];
+}
+
+uint32_t SpatialGrid::cellEnd(int column, int row) const
+{
+	return m_CellStart[m_CellRanks[row * m_Columns + column] + 1];
+}
+
+size_t SpatialGrid::getEntryCount() const
+{
+	return m_BoidEntries.size();
+}
+
+uint32_t SpatialGrid::getEntry(size_t boid) const
+{
+	return m_BoidEntries[boid];
+}
+
+uint32_t SpatialGrid::getBoid(uint32_t entry) const
+{
+	return m_EntryBoids[entry];
+}
+
+const float* SpatialGrid::getX() const
+{
+	return m_X.data();
+}
+
+const float* SpatialGrid::getY() const
+{
+	return m_Y.data();
+}
+
+const float* SpatialGrid::getVX() const
+{
+	return m_VX.data();
+}
+
+const float* SpatialGrid::getVY() const
+{
+	return m_VY.data();
+}
+
+const GroupId* SpatialGrid::getGroups() const
+{
+	return m_Groups.data();
+}
+
+void SpatialGrid::rebuild(const std::vector<BoidGroup>& groups, const std::vector<size_t>& groupOffsets,
+	const Boundary2f& bounds, float cellSize, ThreadPool& threadPool)
+{
+	Vec2f size = bounds.getSize();
+
+	m_Origin = Vec2f(std::min(bounds.min.x, bounds.max.x), std::min(bounds.min.y, bounds.max.y));
+	m_CellSize = std::max(cellSize, std::max(size.x, size.y) / static_cast<float>(m_MaxCellsPerAxis));
+	m_CellSize = std::max(m_CellSize, 1.0f);
+	m_Columns = std::max(1, static_cast<int>(std::ceil(size.x / m_CellSize)));
+	m_Rows = std::max(1, static_cast<int>(std::ceil(size.y / m_CellSize)));
+
+	updateCellRanks();
+
+	size_t cellCount = static_cast<size_t>(m_Columns) * static_cast<size_t>(m_Rows);
+	size_t count = groupOffsets.back();
+	size_t padded = (count + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH;
+	size_t blockCount = getBlockCount(count, cellCount, threadPool);
+
+	m_CellStart.resize(cellCount + 1);
+	m_BlockCounts.resize(blockCount * cellCount);
+	m_EntryCells.resize(count);
+
+	// the boids are split into one contiguous block per worker, every block counts its boids per cell
+	threadPool.run(blockCount, 1, [&](size_t begin, size_t end, size_t /*worker*/)
+	{
+		for (size_t block = begin; block < end; block++)
+		{
+			uint32_t* counts = m_BlockCounts.data() + block * cellCount;
+			std::fill(counts, counts + cellCount, 0);
+
+			forEachGroupRange(groupOffsets, count * block / blockCount, count * (block + 1) / blockCount,
+				[&](size_t group, size_t groupBegin, size_t groupEnd)
+			{
+				const BoidArray& boids = groups[group].getBoids();
+				const float* x = boids.getX();
+				const float* y = boids.getY();
+				uint32_t* cells = m_EntryCells.data() + groupOffsets[group];
+
+				for (size_t j = groupBegin; j < groupEnd; j++)
+				{
+					uint32_t cell = m_CellRanks[getRow(y[j]) * m_Columns + getColumn(x[j])];
+
+					cells[j] = cell;
+					counts[cell]++;
+				}
+			});
+		}
+	});
+
+	// exclusive prefix sum over (cell, block), in two passes over chunks of cells:
+	// first the total of every chunk, then the offsets from the running total of the chunks before it
+	const size_t chunkSize = 16384;
+	size_t chunkCount = (cellCount + chunkSize - 1) / chunkSize;
+	m_CellStart[cellCount] = static_cast<uint32_t>(count);
+
+	threadPool.run(chunkCount, 1, [&](size_t begin, size_t end, size_t /*worker*/)
+	{
+		for (size_t chunk = begin; chunk < end; chunk++)
+		{
+			uint32_t total = 0;
+
+			for (size_t cell = chunk * chunkSize; cell < std::min((chunk + 1) * chunkSize, cellCount); cell++)
+			{
+				for (size_t block = 0; block < blockCount; block++)
+				{
+					total += m_BlockCounts[block * cellCount + cell];
+				}
+			}
+
+			// parked in the start of the chunk's first cell until the scan below
+			m_CellStart[chunk * chunkSize] = total;
+		}
+	});
+
+	uint32_t running = 0;
+	for (size_t chunk = 0; chunk < chunkCount; chunk++)
+	{
+		uint32_t total = m_CellStart[chunk * chunkSize];
+
+		m_CellStart[chunk * chunkSize] = running;
+		running += total;
+	}
+
+	threadPool.run(chunkCount, 1, [&](size_t begin, size_t end, size_t /*worker*/)
+	{
+		for (size_t chunk = begin; chunk < end; chunk++)
+		{
+			uint32_t offset = m_CellStart[chunk * chunkSize];
+
+			for (size_t cell = chunk * chunkSize; cell < std::min((chunk + 1) * chunkSize, cellCount); cell++)
+			{
+				m_CellStart[cell] = offset;
+
+				for (size_t block = 0; block < blockCount; block++)
+				{
+					uint32_t counted = m_BlockCounts[block * cellCount + cell];
+
+					m_BlockCounts[block * cellCount + cell] = offset;
+					offset += counted;
+				}
+			}
+		}
+	});
+
+	// the padding past the last entry stays zero
+	m_X.assign(padded, 0.0f);
+	m_Y.assign(padded, 0.0f);
+	m_VX.assign(padded, 0.0f);
+	m_VY.assign(padded, 0.0f);
+	m_Groups.assign(padded + SIMD_WIDTH, 0);
+	m_BoidEntries.resize(count);
+	m_EntryBoids.resize(count);
+
+	// every block scatters its boids from its own offsets, which keeps the sort stable
+	threadPool.run(blockCount, 1, [&](size_t begin, size_t end, size_t /*worker*/)
+	{
+		for (size_t block = begin; block < end; block++)
+		{
+			uint32_t* offsets = m_BlockCounts.data() + block * cellCount;
+
+			forEachGroupRange(groupOffsets, count * block / blockCount, count * (block + 1) / blockCount,
+				[&](size_t group, size_t groupBegin, size_t groupEnd)
+			{
+				const BoidArray& boids = groups[group].getBoids();
+				const float* x = boids.getX();
+				const float* y = boids.getY();
+				const float* vx = boids.getVX();
+				const float* vy = boids.getVY();
+				size_t firstBoid = groupOffsets[group];
+
+				for (size_t j = groupBegin; j < groupEnd; j++)
+				{
+					uint32_t entry = offsets[m_EntryCells[firstBoid + j]]++;
+
+					m_X[entry] = x[j];
+					m_Y[entry] = y[j];
+					m_VX[entry] = vx[j];
+					m_VY[entry] = vy[j];
+					m_Groups[entry] = static_cast<GroupId>(group);
+					m_BoidEntries[firstBoid + j] = entry;
+					m_EntryBoids[entry] = static_cast<uint32_t>(firstBoid + j);
+				}
+			});
+		}
+	});
+}
+
+void SpatialGrid::refresh(const std::vector<BoidGroup>& groups, const std::vector<size_t>& groupOffsets, ThreadPool& threadPool)
+{
+	threadPool.run(groupOffsets.back(), [&](size_t begin, size_t end, size_t /*worker*/)
+	{
+		forEachGroupRange(groupOffsets, begin, end, [&](size_t group, size_t groupBegin, size_t groupEnd)
+		{
+			const BoidArray& boids = groups[group].getBoids();
+			const float* x = boids.getX();
+			const float* y = boids.getY();
+			const float* vx = boids.getVX();
+			const float* vy = boids.getVY();
+			const uint32_t* entries = m_BoidEntries.data() + groupOffsets[group];
+
+			for (size_t j = groupBegin; j < groupEnd; j++)
+			{
+				uint32_t entry = entries[j];
+
+				m_X[entry] = x[j];
+				m_Y[entry] = y[j];
+				m_VX[entry] = vx[j];
+				m_VY[entry] = vy[j];
+			}
+		});
+	});
+}
+
+void SpatialGrid::sortBoids(const std::vector<size_t>& groupOffsets, std::vector<uint32_t>& order, ThreadPool& threadPool)
+{
+	size_t groupCount = groupOffsets.size() - 1;
+	size_t count = groupOffsets.back();
+	size_t blockCount = getBlockCount(count, groupCount, threadPool);
+
+	order.resize(count);
+	m_BlockCounts.resize(blockCount * groupCount);
+
+	// same counting sort as the rebuild, keyed by group over the entries, which are already in cell order
+	threadPool.run(blockCount, 1, [&](size_t begin, size_t end, size_t /*worker*/)
+	{
+		for (size_t block = begin; block < end; block++)
+		{
+			uint32_t* counts = m_BlockCounts.data() + block * groupCount;
+			std::fill(counts, counts + groupCount, 0);
+
+			for (size_t entry = count * block / blockCount; entry < count * (block + 1) / blockCount; entry++)
+			{
+				counts[m_Groups[entry]]++;
+			}
+		}
+	});
+
+	for (size_t group = 0; group < groupCount; group++)
+	{
+		uint32_t offset = static_cast<uint32_t>(groupOffsets[group]);
+
+		for (size_t block = 0; block < blockCount; block++)
+		{
+			uint32_t counted = m_BlockCounts[block * groupCount + group];
+
+			m_BlockCounts[block * groupCount + group] = offset;
+			offset += counted;
+		}
+	}
+
+	threadPool.run(blockCount, 1, [&](size_t begin, size_t end, size_t /*worker*/)
+	{
+		for (size_t block = begin; block < end; block++)
+		{
+			uint32_t* offsets = m_BlockCounts.data() + block * groupCount;
+
+			for (size_t entry = count * block / blockCount; entry < count * (block + 1) / blockCount; entry++)
+			{
+				uint32_t boid = offsets[m_Groups[entry]]++;
+
+				order[boid] = m_EntryBoids[entry];
+				m_EntryBoids[entry] = boid;
+				m_BoidEntries[boid] = static_cast<uint32_t>(entry);
+			}
+		}
+	});
+}
+
+void SpatialGrid::updateCellRanks()
+{
+	if (m_RankedOrder == m_CellOrder && m_RankedColumns == m_Columns && m_RankedRows == m_Rows)
+	{
+		return;
+	}
+
+	m_RankedOrder = m_CellOrder;
+	m_RankedColumns = m_Columns;
+	m_RankedRows = m_Rows;
+
+	size_t cellCount = static_cast<size_t>(m_Columns) * static_cast<size_t>(m_Rows);
+	m_CellRanks.resize(cellCount);
+
+	if (m_CellOrder == CellOrder::RowMajor)
+	{
+		for (size_t i = 0; i < cellCount; i++)
+		{
+			m_CellRanks[i] = static_cast<uint32_t>(i);
+		}
+
+		return;
+	}
+
+	uint32_t side = 1;
+	while (side < static_cast<uint32_t>(std::max(m_Columns, m_Rows)))
+	{
+		side *= 2;
+	}
+
+	// only runs when the grid changes size, so a plain sort of the cells by curve position will do
+	std::vector<std::pair<uint64_t, uint32_t>> keys(cellCount);
+	for (int row = 0; row < m_Rows; row++)
+	{
+		for (int column = 0; column < m_Columns; column++)
+		{
+			uint32_t cell = static_cast<uint32_t>(row * m_Columns + column);
+			uint64_t key = m_CellOrder == CellOrder::Morton ? mortonKey(column, row) : hilbertKey(side, column, row);
+
+			keys[cell] = std::make_pair(key, cell);
+		}
+	}
+	std::sort(keys.begin(), keys.end());
+
+	for (size_t i = 0; i < cellCount; i++)
+	{
+		m_CellRanks[keys[i].second] = static_cast<uint32_t>(i);
+	}
+}
+
+size_t SpatialGrid::getBlockCount(size_t count, size_t keyCount, const ThreadPool& threadPool) const
+{
+	size_t blockCount = std::min(threadPool.getThreadCount(), count / m_MinBlockSize);
+
+	return std::max<size_t>(1, std::min(blockCount, count / std::max<size_t>(keyCount, 1)));
+}
+
+void SpatialGrid::aggregate(size_t groupCount, ThreadPool& threadPool)
+{
+	size_t cellCount = m_CellStart.size() - 1;
+
+	m_AggregateGroups = groupCount;
+	m_Aggregates.resize(cellCount * groupCount);
+
+	// cells are contiguous runs of entries, so every cell is summed by a single worker;
+	// most cells of a fine grid are empty and are left as they are, nothing reads them
+	threadPool.run(cellCount, [&](size_t begin, size_t end, size_t /*worker*/)
+	{
+		for (size_t cell = begin; cell < end; cell++)
+		{
+			if (m_CellStart[cell] == m_CellStart[cell + 1])
+			{
+				continue;
+			}
+
+			CellAggregate* aggregates = m_Aggregates.data() + cell * groupCount;
+			std::fill(aggregates, aggregates + groupCount, CellAggregate());
+
+			for (uint32_t i = m_CellStart[cell]; i < m_CellStart[cell + 1]; i++)
+			{
+				CellAggregate& aggregate = aggregates[m_Groups[i]];
+
+				aggregate.positionX += m_X[i];
+				aggregate.positionY += m_Y[i];
+				aggregate.velocityX += m_VX[i];
+				aggregate.velocityY += m_VY[i];
+				aggregate.count++;
+			}
+		}
+	});
+}
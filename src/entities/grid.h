@@ -0,0 +1,119 @@
+#pragma once
+
+#include "../utils/vecmath.h"
+#include "../utils/aligned.h"
+#include "../utils/threadpool.h"
+#include "kernels.h"
+#include <vector>
+#include <cstdint>
+
+class BoidGroup;
+
+/************************************************************************************************************
+* Order in which the cells of the grid are laid out in memory.
+* Morton (Z-order) and Hilbert curves keep cells that are close in both axes close in memory,
+* row-major order only along a row.
+*************************************************************************************************************/
+enum class CellOrder
+{
+	RowMajor,
+	Morton,
+	Hilbert
+};
+
+/************************************************************************************************************
+* Sums over the boids of one group in one cell.
+*************************************************************************************************************/
+struct CellAggregate
+{
+	CellAggregate();
+
+	float positionX;
+	float positionY;
+	float velocityX;
+	float velocityY;
+	uint32_t count;
+};
+
+/************************************************************************************************************
+* Uniform grid over the boid boundary, rebuilt once per tick with a parallel counting sort.
+* Boids outside the boundary are clamped into the border cells, so a query over the 3x3 block of cells
+* around a point finds every boid closer than the cell size.
+* The rebuild also copies the state of every boid into entry arrays in cell order, so the boids of a cell
+* are contiguous. Boids are numbered globally, group after group, and getEntry maps that number to an entry.
+* refresh copies the current state into the entries without sorting them again, the cells then go stale.
+* aggregate sums the entries of every cell per group, for queries that only need the mean of a cell.
+*************************************************************************************************************/
+class SpatialGrid
+{
+public:
+	SpatialGrid();
+
+	const Vec2f& getOrigin() const;
+	float getCellSize() const;
+	int getColumns() const;
+	int getRows() const;
+
+	CellOrder getCellOrder() const;
+	void setCellOrder(CellOrder order);
+
+	int getColumn(float x) const;
+	int getRow(float y) const;
+
+	uint32_t cellBegin(int column, int row) const;
+	uint32_t cellEnd(int column, int row) const;
+
+	size_t getEntryCount() const;
+	uint32_t getEntry(size_t boid) const;
+	uint32_t getBoid(uint32_t entry) const;
+
+	const float* getX() const;
+	const float* getY() const;
+	const float* getVX() const;
+	const float* getVY() const;
+	// padded with SIMD_WIDTH zeros past the last entry
+	const GroupId* getGroups() const;
+	// groupCount aggregates, one per group, valid after aggregate for the cells that hold boids
+	const CellAggregate* getAggregates(int column, int row) const;
+
+	void rebuild(const std::vector<BoidGroup>& groups, const std::vector<size_t>& groupOffsets,
+		const Boundary2f& bounds, float cellSize, ThreadPool& threadPool);
+	void refresh(const std::vector<BoidGroup>& groups, const std::vector<size_t>& groupOffsets, ThreadPool& threadPool);
+	void sortBoids(const std::vector<size_t>& groupOffsets, std::vector<uint32_t>& order, ThreadPool& threadPool);
+	void aggregate(size_t groupCount, ThreadPool& threadPool);
+
+private:
+	void updateCellRanks();
+	// blocks of boids counted in parallel, each with a count per key, kept to no more counts than boids
+	size_t getBlockCount(size_t count, size_t keyCount, const ThreadPool& threadPool) const;
+
+private:
+	Vec2f m_Origin;
+	float m_CellSize;
+	int m_Columns;
+	int m_Rows;
+
+	CellOrder m_CellOrder;
+	CellOrder m_RankedOrder;
+	int m_RankedColumns;
+	int m_RankedRows;
+	std::vector<uint32_t> m_CellRanks;
+
+	std::vector<uint32_t> m_CellStart;
+	std::vector<uint32_t> m_BlockCounts;
+	std::vector<uint32_t> m_EntryCells;
+	std::vector<uint32_t> m_BoidEntries;
+	std::vector<uint32_t> m_EntryBoids;
+
+	AlignedVector<float> m_X;
+	AlignedVector<float> m_Y;
+	AlignedVector<float> m_VX;
+	AlignedVector<float> m_VY;
+	AlignedVector<GroupId> m_Groups;
+
+	size_t m_AggregateGroups;
+	std::vector<CellAggregate> m_Aggregates;
+
+	static constexpr int m_MaxCellsPerAxis = 1024;
+	static constexpr size_t m_MinBlockSize = 4096;
+};
@@ -0,0 +1,868 @@
+#include "kernels.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SIMD_X86
+#include <immintrin.h>
+#endif
+
+// MSVC compiles any intrinsic anywhere, GCC and Clang only in functions built for its instruction set
+#if defined(_MSC_VER)
+#define SIMD_TARGET(isa)
+#else
+#define SIMD_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+// GCC fuses multiplies and adds into FMAs in the functions built for AVX-512, which rounds once instead of twice
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+KernelOptions::KernelOptions()
+{
+	simdLevel = detectSimdLevel();
+	fastReciprocal = false;
+}
+
+IntegrationSummary::IntegrationSummary()
+{
+	float max = std::numeric_limits<float>::max();
+
+	bounds = Boundary2f(Vec2f(max, max), Vec2f(-max, -max));
+	positionSum = Vec2f(0.0f, 0.0f);
+	velocitySum = Vec2f(0.0f, 0.0f);
+}
+
+void IntegrationSummary::merge(const IntegrationSummary& other)
+{
+	bounds.extend(other.bounds);
+	positionSum += other.positionSum;
+	velocitySum += other.velocitySum;
+}
+
+static size_t filterNearScalar(const float* x, const float* y, const GroupId* groups, const float* searchDistances2,
+	float px, float py, uint32_t begin, uint32_t end, uint32_t* out)
+{
+	size_t count = 0;
+
+	for (uint32_t i = begin; i < end; i++)
+	{
+		float dx = px - x[i];
+		float dy = py - y[i];
+		float distance2 = dx * dx + dy * dy;
+
+		if (distance2 <= searchDistances2[groups[i]])
+		{
+			out[count++] = i;
+		}
+	}
+
+	return count;
+}
+
+static size_t accumulateNeighborsScalar(const float* x, const float* y, const float* vx, const float* vy,
+	const GroupId* groups, const float* viewDistances2, const uint32_t* neighbors, size_t count, float px, float py,
+	float minDistance2, float* sums)
+{
+	size_t added = 0;
+
+	for (size_t j = 0; j < count; j++)
+	{
+		uint32_t i = neighbors[j];
+		float dx = px - x[i];
+		float dy = py - y[i];
+		float distance2 = dx * dx + dy * dy;
+
+		// lists built with a skin also hold boids a little beyond the view distance
+		if (viewDistances2 && distance2 > viewDistances2[groups[i]])
+		{
+			continue;
+		}
+
+		sums[0] += x[i];
+		sums[1] += y[i];
+		sums[4] += vx[i];
+		sums[5] += vy[i];
+
+		// coincident boids have no direction to separate along, 0 / 0 would poison the whole school
+		if (distance2 > 0.0f)
+		{
+			float scale = distance2 / minDistance2;
+
+			sums[2] += dx / scale;
+			sums[3] += dy / scale;
+		}
+
+		added++;
+	}
+
+	return added;
+}
+
+// the same steps as Boid::constrainBounds, Boid::constrainSpeed and Boid::update
+static void integrateBoidsScalar(float* x, float* y, float* vx, float* vy, size_t count, float dt,
+	const Boundary2f& boundary, const Vec2f& boundaryRepel, float maxSpeed, IntegrationSummary& summary)
+{
+	float maxSpeed2 = maxSpeed * maxSpeed;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		float velocityX = vx[i];
+		float velocityY = vy[i];
+
+		if (x[i] < boundary.min.x)
+		{
+			velocityX += boundaryRepel.x;
+		}
+		else if (x[i] > boundary.max.x)
+		{
+			velocityX -= boundaryRepel.x;
+		}
+
+		if (y[i] < boundary.min.y)
+		{
+			velocityY += boundaryRepel.y;
+		}
+		else if (y[i] > boundary.max.y)
+		{
+			velocityY -= boundaryRepel.y;
+		}
+
+		float speed2 = velocityX * velocityX + velocityY * velocityY;
+
+		if (speed2 >= maxSpeed2)
+		{
+			float speed = sqrtf(speed2);
+
+			velocityX = velocityX / speed * maxSpeed;
+			velocityY = velocityY / speed * maxSpeed;
+		}
+
+		Vec2f position(x[i] + velocityX * dt, y[i] + velocityY * dt);
+
+		x[i] = position.x;
+		y[i] = position.y;
+		vx[i] = velocityX;
+		vy[i] = velocityY;
+
+		summary.bounds.extend(position);
+		summary.positionSum += position;
+		summary.velocitySum += Vec2f(velocityX, velocityY);
+	}
+}
+
+// folds the per lane boxes of a SIMD kernel into the summary
+static void extendByLanes(IntegrationSummary& summary, const float* minX, const float* minY, const float* maxX,
+	const float* maxY, size_t lanes)
+{
+	for (size_t i = 0; i < lanes; i++)
+	{
+		summary.bounds.extend(Boundary2f(minX[i], minY[i], maxX[i], maxY[i]));
+	}
+}
+
+#ifdef SIMD_X86
+
+/************************************************************************************************************
+* For every 8 bit mask, the lanes that are set, packed to the front, and how many there are.
+*************************************************************************************************************/
+struct CompressTable
+{
+	CompressTable();
+
+	uint8_t lanes[256][8];
+	uint8_t counts[256];
+};
+
+CompressTable::CompressTable()
+{
+	for (int mask = 0; mask < 256; mask++)
+	{
+		int count = 0;
+
+		for (int lane = 0; lane < 8; lane++)
+		{
+			lanes[mask][lane] = 0;
+		}
+		for (int lane = 0; lane < 8; lane++)
+		{
+			if (mask & (1 << lane))
+			{
+				lanes[mask][count++] = static_cast<uint8_t>(lane);
+			}
+		}
+
+		counts[mask] = static_cast<uint8_t>(count);
+	}
+}
+
+static const CompressTable s_CompressTable;
+
+SIMD_TARGET("sse2")
+static size_t filterNearSSE2(const float* x, const float* y, const GroupId* groups, const float* searchDistances2,
+	float px, float py, uint32_t begin, uint32_t end, uint32_t* out)
+{
+	__m128 positionX = _mm_set1_ps(px);
+	__m128 positionY = _mm_set1_ps(py);
+	size_t count = 0;
+	uint32_t i = begin;
+
+	for (; i + 4 <= end; i += 4)
+	{
+		__m128 dx = _mm_sub_ps(positionX, _mm_loadu_ps(x + i));
+		__m128 dy = _mm_sub_ps(positionY, _mm_loadu_ps(y + i));
+		__m128 distance2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+		__m128 limit = _mm_setr_ps(searchDistances2[groups[i]], searchDistances2[groups[i + 1]],
+			searchDistances2[groups[i + 2]], searchDistances2[groups[i + 3]]);
+		int mask = _mm_movemask_ps(_mm_cmple_ps(distance2, limit));
+
+		// every lane is written, only those that pass move the end of the output
+		out[count] = i;
+		count += mask & 1;
+		out[count] = i + 1;
+		count += (mask >> 1) & 1;
+		out[count] = i + 2;
+		count += (mask >> 2) & 1;
+		out[count] = i + 3;
+		count += (mask >> 3) & 1;
+	}
+
+	return count + filterNearScalar(x, y, groups, searchDistances2, px, py, i, end, out + count);
+}
+
+SIMD_TARGET("avx2")
+static size_t filterNearAVX2(const float* x, const float* y, const GroupId* groups, const float* searchDistances2,
+	float px, float py, uint32_t begin, uint32_t end, uint32_t* out)
+{
+	__m256 positionX = _mm256_set1_ps(px);
+	__m256 positionY = _mm256_set1_ps(py);
+	size_t count = 0;
+	uint32_t i = begin;
+
+	for (; i + 8 <= end; i += 8)
+	{
+		__m256 dx = _mm256_sub_ps(positionX, _mm256_loadu_ps(x + i));
+		__m256 dy = _mm256_sub_ps(positionY, _mm256_loadu_ps(y + i));
+		__m256 distance2 = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+		__m256i group = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(groups + i)));
+		__m256 limit = _mm256_i32gather_ps(searchDistances2, group, 4);
+		int mask = _mm256_movemask_ps(_mm256_cmp_ps(distance2, limit, _CMP_LE_OQ));
+
+		// all 8 lanes are stored, the passing ones first
+		__m128i packed = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(s_CompressTable.lanes[mask]));
+		__m256i indices = _mm256_add_epi32(_mm256_cvtepu8_epi32(packed), _mm256_set1_epi32(static_cast<int>(i)));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + count), indices);
+		count += s_CompressTable.counts[mask];
+	}
+
+	_mm256_zeroupper();
+
+	return count + filterNearScalar(x, y, groups, searchDistances2, px, py, i, end, out + count);
+}
+
+SIMD_TARGET("avx512f")
+static size_t filterNearAVX512(const float* x, const float* y, const GroupId* groups, const float* searchDistances2,
+	float px, float py, uint32_t begin, uint32_t end, uint32_t* out)
+{
+	__m512 positionX = _mm512_set1_ps(px);
+	__m512 positionY = _mm512_set1_ps(py);
+	__m512i lanes = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+	size_t count = 0;
+
+	// the last block masks off the lanes past the end instead of falling back to scalar code
+	for (uint32_t i = begin; i < end; i += 16)
+	{
+		__mmask16 valid = end - i >= 16 ? static_cast<__mmask16>(0xffff) : static_cast<__mmask16>((1u << (end - i)) - 1);
+		__m512 dx = _mm512_sub_ps(positionX, _mm512_maskz_loadu_ps(valid, x + i));
+		__m512 dy = _mm512_sub_ps(positionY, _mm512_maskz_loadu_ps(valid, y + i));
+		__m512 distance2 = _mm512_add_ps(_mm512_mul_ps(dx, dx), _mm512_mul_ps(dy, dy));
+		__m512i group = _mm512_maskz_cvtepu8_epi32(valid, _mm_loadu_si128(reinterpret_cast<const __m128i*>(groups + i)));
+		__m512 limit = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), valid, group, searchDistances2, 4);
+		__mmask16 mask = _mm512_mask_cmp_ps_mask(valid, distance2, limit, _CMP_LE_OQ);
+
+		_mm512_mask_compressstoreu_epi32(out + count, mask, _mm512_add_epi32(lanes, _mm512_set1_epi32(static_cast<int>(i))));
+		count += s_CompressTable.counts[mask & 0xff] + s_CompressTable.counts[mask >> 8];
+	}
+
+	_mm256_zeroupper();
+
+	return count;
+}
+
+// the SIMD steering kernels add whole blocks of neighbors and leave the rest of the list to the scalar one,
+// neighbor lists are short and a masked last block would cost more than it saves
+SIMD_TARGET("sse2")
+static float reduceSSE2(__m128 v)
+{
+	v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+	v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 1));
+
+	return _mm_cvtss_f32(v);
+}
+
+SIMD_TARGET("avx2")
+static float reduceAVX2(__m256 v)
+{
+	return reduceSSE2(_mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1)));
+}
+
+SIMD_TARGET("avx512f")
+static float reduceAVX512(__m512 v)
+{
+	alignas(64) float lanes[16];
+	_mm512_store_ps(lanes, v);
+
+	return reduceSSE2(_mm_add_ps(_mm_add_ps(_mm_load_ps(lanes), _mm_load_ps(lanes + 4)),
+		_mm_add_ps(_mm_load_ps(lanes + 8), _mm_load_ps(lanes + 12))));
+}
+
+SIMD_TARGET("sse2")
+static size_t accumulateNeighborsSSE2(bool fastReciprocal, const float* x, const float* y, const float* vx, const float* vy,
+	const GroupId* groups, const float* viewDistances2, const uint32_t* neighbors, size_t count, float px, float py,
+	float minDistance2, float* sums)
+{
+	__m128 positionX = _mm_set1_ps(px);
+	__m128 positionY = _mm_set1_ps(py);
+	__m128 minDistances2 = _mm_set1_ps(minDistance2);
+	__m128 zero = _mm_setzero_ps();
+	__m128 two = _mm_set1_ps(2.0f);
+	__m128 positionTotalX = zero;
+	__m128 positionTotalY = zero;
+	__m128 separationTotalX = zero;
+	__m128 separationTotalY = zero;
+	__m128 velocityTotalX = zero;
+	__m128 velocityTotalY = zero;
+	size_t added = 0;
+	size_t j = 0;
+
+	for (; j + 4 <= count; j += 4)
+	{
+		// SSE2 has no gather, the lanes are loaded one by one
+		uint32_t i0 = neighbors[j];
+		uint32_t i1 = neighbors[j + 1];
+		uint32_t i2 = neighbors[j + 2];
+		uint32_t i3 = neighbors[j + 3];
+		__m128 neighborX = _mm_setr_ps(x[i0], x[i1], x[i2], x[i3]);
+		__m128 neighborY = _mm_setr_ps(y[i0], y[i1], y[i2], y[i3]);
+		__m128 dx = _mm_sub_ps(positionX, neighborX);
+		__m128 dy = _mm_sub_ps(positionY, neighborY);
+		__m128 distance2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+		__m128 seen = _mm_cmpeq_ps(zero, zero);
+
+		if (viewDistances2)
+		{
+			__m128 limit = _mm_setr_ps(viewDistances2[groups[i0]], viewDistances2[groups[i1]],
+				viewDistances2[groups[i2]], viewDistances2[groups[i3]]);
+			seen = _mm_cmple_ps(distance2, limit);
+		}
+		__m128 separating = _mm_and_ps(seen, _mm_cmpgt_ps(distance2, zero));
+		__m128 separationX;
+		__m128 separationY;
+
+		if (fastReciprocal)
+		{
+			__m128 reciprocal = _mm_rcp_ps(distance2);
+			reciprocal = _mm_mul_ps(reciprocal, _mm_sub_ps(two, _mm_mul_ps(distance2, reciprocal)));
+			__m128 weight = _mm_and_ps(_mm_mul_ps(minDistances2, reciprocal), separating);
+
+			separationX = _mm_mul_ps(dx, weight);
+			separationY = _mm_mul_ps(dy, weight);
+		}
+		else
+		{
+			__m128 scale = _mm_div_ps(distance2, minDistances2);
+
+			separationX = _mm_and_ps(_mm_div_ps(dx, scale), separating);
+			separationY = _mm_and_ps(_mm_div_ps(dy, scale), separating);
+		}
+
+		positionTotalX = _mm_add_ps(positionTotalX, _mm_and_ps(neighborX, seen));
+		positionTotalY = _mm_add_ps(positionTotalY, _mm_and_ps(neighborY, seen));
+		separationTotalX = _mm_add_ps(separationTotalX, separationX);
+		separationTotalY = _mm_add_ps(separationTotalY, separationY);
+		velocityTotalX = _mm_add_ps(velocityTotalX, _mm_and_ps(_mm_setr_ps(vx[i0], vx[i1], vx[i2], vx[i3]), seen));
+		velocityTotalY = _mm_add_ps(velocityTotalY, _mm_and_ps(_mm_setr_ps(vy[i0], vy[i1], vy[i2], vy[i3]), seen));
+		added += s_CompressTable.counts[_mm_movemask_ps(seen)];
+	}
+
+	if (j)
+	{
+		sums[0] += reduceSSE2(positionTotalX);
+		sums[1] += reduceSSE2(positionTotalY);
+		sums[2] += reduceSSE2(separationTotalX);
+		sums[3] += reduceSSE2(separationTotalY);
+		sums[4] += reduceSSE2(velocityTotalX);
+		sums[5] += reduceSSE2(velocityTotalY);
+	}
+
+	return added + accumulateNeighborsScalar(x, y, vx, vy, groups, viewDistances2, neighbors + j, count - j,
+		px, py, minDistance2, sums);
+}
+
+SIMD_TARGET("avx2")
+static size_t accumulateNeighborsAVX2(bool fastReciprocal, const float* x, const float* y, const float* vx, const float* vy,
+	const GroupId* groups, const float* viewDistances2, const uint32_t* neighbors, size_t count, float px, float py,
+	float minDistance2, float* sums)
+{
+	__m256 positionX = _mm256_set1_ps(px);
+	__m256 positionY = _mm256_set1_ps(py);
+	__m256 minDistances2 = _mm256_set1_ps(minDistance2);
+	__m256 zero = _mm256_setzero_ps();
+	__m256 two = _mm256_set1_ps(2.0f);
+	__m256 positionTotalX = zero;
+	__m256 positionTotalY = zero;
+	__m256 separationTotalX = zero;
+	__m256 separationTotalY = zero;
+	__m256 velocityTotalX = zero;
+	__m256 velocityTotalY = zero;
+	// the ids are gathered as the 32-bit words they start, the grid pads its ids for the last ones
+	__m256i idMask = _mm256_set1_epi32(0xff);
+	size_t added = 0;
+	size_t j = 0;
+
+	for (; j + 8 <= count; j += 8)
+	{
+		__m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(neighbors + j));
+		__m256 neighborX = _mm256_i32gather_ps(x, index, 4);
+		__m256 neighborY = _mm256_i32gather_ps(y, index, 4);
+		__m256 dx = _mm256_sub_ps(positionX, neighborX);
+		__m256 dy = _mm256_sub_ps(positionY, neighborY);
+		__m256 distance2 = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+		__m256 seen = _mm256_cmp_ps(zero, zero, _CMP_EQ_OQ);
+
+		if (viewDistances2)
+		{
+			__m256i group = _mm256_and_si256(_mm256_i32gather_epi32(reinterpret_cast<const int*>(groups), index, 1), idMask);
+			seen = _mm256_cmp_ps(distance2, _mm256_i32gather_ps(viewDistances2, group, 4), _CMP_LE_OQ);
+		}
+
+		__m256 separating = _mm256_and_ps(seen, _mm256_cmp_ps(distance2, zero, _CMP_GT_OQ));
+		__m256 separationX;
+		__m256 separationY;
+
+		if (fastReciprocal)
+		{
+			__m256 reciprocal = _mm256_rcp_ps(distance2);
+			reciprocal = _mm256_mul_ps(reciprocal, _mm256_sub_ps(two, _mm256_mul_ps(distance2, reciprocal)));
+			__m256 weight = _mm256_and_ps(_mm256_mul_ps(minDistances2, reciprocal), separating);
+
+			separationX = _mm256_mul_ps(dx, weight);
+			separationY = _mm256_mul_ps(dy, weight);
+		}
+		else
+		{
+			__m256 scale = _mm256_div_ps(distance2, minDistances2);
+
+			separationX = _mm256_and_ps(_mm256_div_ps(dx, scale), separating);
+			separationY = _mm256_and_ps(_mm256_div_ps(dy, scale), separating);
+		}
+
+		positionTotalX = _mm256_add_ps(positionTotalX, _mm256_and_ps(neighborX, seen));
+		positionTotalY = _mm256_add_ps(positionTotalY, _mm256_and_ps(neighborY, seen));
+		separationTotalX = _mm256_add_ps(separationTotalX, separationX);
+		separationTotalY = _mm256_add_ps(separationTotalY, separationY);
+		velocityTotalX = _mm256_add_ps(velocityTotalX, _mm256_and_ps(_mm256_i32gather_ps(vx, index, 4), seen));
+		velocityTotalY = _mm256_add_ps(velocityTotalY, _mm256_and_ps(_mm256_i32gather_ps(vy, index, 4), seen));
+		added += s_CompressTable.counts[_mm256_movemask_ps(seen)];
+	}
+
+	if (j)
+	{
+		sums[0] += reduceAVX2(positionTotalX);
+		sums[1] += reduceAVX2(positionTotalY);
+		sums[2] += reduceAVX2(separationTotalX);
+		sums[3] += reduceAVX2(separationTotalY);
+		sums[4] += reduceAVX2(velocityTotalX);
+		sums[5] += reduceAVX2(velocityTotalY);
+	}
+
+	// the scalar code after this is not VEX encoded, dirty upper halves would slow it down
+	_mm256_zeroupper();
+
+	return added + accumulateNeighborsScalar(x, y, vx, vy, groups, viewDistances2, neighbors + j, count - j,
+		px, py, minDistance2, sums);
+}
+
+SIMD_TARGET("avx512f")
+static size_t accumulateNeighborsAVX512(bool fastReciprocal, const float* x, const float* y, const float* vx, const float* vy,
+	const GroupId* groups, const float* viewDistances2, const uint32_t* neighbors, size_t count, float px, float py,
+	float minDistance2, float* sums)
+{
+	__m512 positionX = _mm512_set1_ps(px);
+	__m512 positionY = _mm512_set1_ps(py);
+	__m512 minDistances2 = _mm512_set1_ps(minDistance2);
+	__m512 zero = _mm512_setzero_ps();
+	__m512 two = _mm512_set1_ps(2.0f);
+	__m512 positionTotalX = zero;
+	__m512 positionTotalY = zero;
+	__m512 separationTotalX = zero;
+	__m512 separationTotalY = zero;
+	__m512 velocityTotalX = zero;
+	__m512 velocityTotalY = zero;
+	__mmask16 all = static_cast<__mmask16>(0xffff);
+	__m512i idMask = _mm512_set1_epi32(0xff);
+	size_t added = 0;
+	size_t j = 0;
+
+	for (; j + 16 <= count; j += 16)
+	{
+		__m512i index = _mm512_loadu_si512(neighbors + j);
+		__m512 neighborX = _mm512_mask_i32gather_ps(zero, all, index, x, 4);
+		__m512 neighborY = _mm512_mask_i32gather_ps(zero, all, index, y, 4);
+		__m512 dx = _mm512_sub_ps(positionX, neighborX);
+		__m512 dy = _mm512_sub_ps(positionY, neighborY);
+		__m512 distance2 = _mm512_add_ps(_mm512_mul_ps(dx, dx), _mm512_mul_ps(dy, dy));
+		__mmask16 seen = all;
+
+		if (viewDistances2)
+		{
+			__m512i group = _mm512_and_epi32(_mm512_mask_i32gather_epi32(_mm512_setzero_si512(), all, index, groups, 1), idMask);
+			seen = _mm512_cmp_ps_mask(distance2, _mm512_mask_i32gather_ps(zero, all, group, viewDistances2, 4), _CMP_LE_OQ);
+		}
+
+		__mmask16 separating = _mm512_mask_cmp_ps_mask(seen, distance2, zero, _CMP_GT_OQ);
+
+		if (fastReciprocal)
+		{
+			__m512 reciprocal = _mm512_maskz_rcp14_ps(separating, distance2);
+			reciprocal = _mm512_mul_ps(reciprocal, _mm512_sub_ps(two, _mm512_mul_ps(distance2, reciprocal)));
+			__m512 weight = _mm512_maskz_mul_ps(separating, minDistances2, reciprocal);
+
+			separationTotalX = _mm512_add_ps(separationTotalX, _mm512_mul_ps(dx, weight));
+			separationTotalY = _mm512_add_ps(separationTotalY, _mm512_mul_ps(dy, weight));
+		}
+		else
+		{
+			__m512 scale = _mm512_div_ps(distance2, minDistances2);
+
+			separationTotalX = _mm512_mask_add_ps(separationTotalX, separating, separationTotalX, _mm512_div_ps(dx, scale));
+			separationTotalY = _mm512_mask_add_ps(separationTotalY, separating, separationTotalY, _mm512_div_ps(dy, scale));
+		}
+
+		positionTotalX = _mm512_mask_add_ps(positionTotalX, seen, positionTotalX, neighborX);
+		positionTotalY = _mm512_mask_add_ps(positionTotalY, seen, positionTotalY, neighborY);
+		velocityTotalX = _mm512_mask_add_ps(velocityTotalX, seen, velocityTotalX, _mm512_mask_i32gather_ps(zero, seen, index, vx, 4));
+		velocityTotalY = _mm512_mask_add_ps(velocityTotalY, seen, velocityTotalY, _mm512_mask_i32gather_ps(zero, seen, index, vy, 4));
+		added += s_CompressTable.counts[seen & 0xff] + s_CompressTable.counts[seen >> 8];
+	}
+
+	if (j)
+	{
+		sums[0] += reduceAVX512(positionTotalX);
+		sums[1] += reduceAVX512(positionTotalY);
+		sums[2] += reduceAVX512(separationTotalX);
+		sums[3] += reduceAVX512(separationTotalY);
+		sums[4] += reduceAVX512(velocityTotalX);
+		sums[5] += reduceAVX512(velocityTotalY);
+	}
+
+	_mm256_zeroupper();
+
+	return added + accumulateNeighborsScalar(x, y, vx, vy, groups, viewDistances2, neighbors + j, count - j,
+		px, py, minDistance2, sums);
+}
+
+// the integration kernels select the moved lanes instead of branching, sqrt and division are exact
+// in every instruction set, so the boids move as they do in the scalar kernel
+SIMD_TARGET("sse2")
+static __m128 selectSSE2(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+SIMD_TARGET("sse2")
+static void integrateBoidsSSE2(float* x, float* y, float* vx, float* vy, size_t count, float dt,
+	const Boundary2f& boundary, const Vec2f& boundaryRepel, float maxSpeed, IntegrationSummary& summary)
+{
+	__m128 boundaryMinX = _mm_set1_ps(boundary.min.x);
+	__m128 boundaryMinY = _mm_set1_ps(boundary.min.y);
+	__m128 boundaryMaxX = _mm_set1_ps(boundary.max.x);
+	__m128 boundaryMaxY = _mm_set1_ps(boundary.max.y);
+	__m128 repelX = _mm_set1_ps(boundaryRepel.x);
+	__m128 repelY = _mm_set1_ps(boundaryRepel.y);
+	__m128 maxSpeeds = _mm_set1_ps(maxSpeed);
+	__m128 maxSpeeds2 = _mm_set1_ps(maxSpeed * maxSpeed);
+	__m128 dts = _mm_set1_ps(dt);
+	__m128 minX = _mm_set1_ps(summary.bounds.min.x);
+	__m128 minY = _mm_set1_ps(summary.bounds.min.y);
+	__m128 maxX = _mm_set1_ps(summary.bounds.max.x);
+	__m128 maxY = _mm_set1_ps(summary.bounds.max.y);
+	__m128 positionTotalX = _mm_setzero_ps();
+	__m128 positionTotalY = _mm_setzero_ps();
+	__m128 velocityTotalX = _mm_setzero_ps();
+	__m128 velocityTotalY = _mm_setzero_ps();
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 positionX = _mm_loadu_ps(x + i);
+		__m128 positionY = _mm_loadu_ps(y + i);
+		__m128 velocityX = _mm_loadu_ps(vx + i);
+		__m128 velocityY = _mm_loadu_ps(vy + i);
+
+		velocityX = selectSSE2(_mm_cmplt_ps(positionX, boundaryMinX), _mm_add_ps(velocityX, repelX),
+			selectSSE2(_mm_cmpgt_ps(positionX, boundaryMaxX), _mm_sub_ps(velocityX, repelX), velocityX));
+		velocityY = selectSSE2(_mm_cmplt_ps(positionY, boundaryMinY), _mm_add_ps(velocityY, repelY),
+			selectSSE2(_mm_cmpgt_ps(positionY, boundaryMaxY), _mm_sub_ps(velocityY, repelY), velocityY));
+
+		__m128 speed2 = _mm_add_ps(_mm_mul_ps(velocityX, velocityX), _mm_mul_ps(velocityY, velocityY));
+		__m128 clamped = _mm_cmpge_ps(speed2, maxSpeeds2);
+		__m128 speed = _mm_sqrt_ps(speed2);
+
+		velocityX = selectSSE2(clamped, _mm_mul_ps(_mm_div_ps(velocityX, speed), maxSpeeds), velocityX);
+		velocityY = selectSSE2(clamped, _mm_mul_ps(_mm_div_ps(velocityY, speed), maxSpeeds), velocityY);
+		positionX = _mm_add_ps(positionX, _mm_mul_ps(velocityX, dts));
+		positionY = _mm_add_ps(positionY, _mm_mul_ps(velocityY, dts));
+
+		_mm_storeu_ps(x + i, positionX);
+		_mm_storeu_ps(y + i, positionY);
+		_mm_storeu_ps(vx + i, velocityX);
+		_mm_storeu_ps(vy + i, velocityY);
+
+		minX = _mm_min_ps(minX, positionX);
+		minY = _mm_min_ps(minY, positionY);
+		maxX = _mm_max_ps(maxX, positionX);
+		maxY = _mm_max_ps(maxY, positionY);
+		positionTotalX = _mm_add_ps(positionTotalX, positionX);
+		positionTotalY = _mm_add_ps(positionTotalY, positionY);
+		velocityTotalX = _mm_add_ps(velocityTotalX, velocityX);
+		velocityTotalY = _mm_add_ps(velocityTotalY, velocityY);
+	}
+
+	alignas(16) float lanes[4][4];
+	_mm_store_ps(lanes[0], minX);
+	_mm_store_ps(lanes[1], minY);
+	_mm_store_ps(lanes[2], maxX);
+	_mm_store_ps(lanes[3], maxY);
+	extendByLanes(summary, lanes[0], lanes[1], lanes[2], lanes[3], 4);
+
+	summary.positionSum += Vec2f(reduceSSE2(positionTotalX), reduceSSE2(positionTotalY));
+	summary.velocitySum += Vec2f(reduceSSE2(velocityTotalX), reduceSSE2(velocityTotalY));
+
+	integrateBoidsScalar(x + i, y + i, vx + i, vy + i, count - i, dt, boundary, boundaryRepel, maxSpeed, summary);
+}
+
+SIMD_TARGET("avx2")
+static void integrateBoidsAVX2(float* x, float* y, float* vx, float* vy, size_t count, float dt,
+	const Boundary2f& boundary, const Vec2f& boundaryRepel, float maxSpeed, IntegrationSummary& summary)
+{
+	__m256 boundaryMinX = _mm256_set1_ps(boundary.min.x);
+	__m256 boundaryMinY = _mm256_set1_ps(boundary.min.y);
+	__m256 boundaryMaxX = _mm256_set1_ps(boundary.max.x);
+	__m256 boundaryMaxY = _mm256_set1_ps(boundary.max.y);
+	__m256 repelX = _mm256_set1_ps(boundaryRepel.x);
+	__m256 repelY = _mm256_set1_ps(boundaryRepel.y);
+	__m256 maxSpeeds = _mm256_set1_ps(maxSpeed);
+	__m256 maxSpeeds2 = _mm256_set1_ps(maxSpeed * maxSpeed);
+	__m256 dts = _mm256_set1_ps(dt);
+	__m256 minX = _mm256_set1_ps(summary.bounds.min.x);
+	__m256 minY = _mm256_set1_ps(summary.bounds.min.y);
+	__m256 maxX = _mm256_set1_ps(summary.bounds.max.x);
+	__m256 maxY = _mm256_set1_ps(summary.bounds.max.y);
+	__m256 positionTotalX = _mm256_setzero_ps();
+	__m256 positionTotalY = _mm256_setzero_ps();
+	__m256 velocityTotalX = _mm256_setzero_ps();
+	__m256 velocityTotalY = _mm256_setzero_ps();
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 positionX = _mm256_loadu_ps(x + i);
+		__m256 positionY = _mm256_loadu_ps(y + i);
+		__m256 velocityX = _mm256_loadu_ps(vx + i);
+		__m256 velocityY = _mm256_loadu_ps(vy + i);
+
+		// blendv takes the second operand where the mask is set, the lower test wins as in the scalar else if
+		velocityX = _mm256_blendv_ps(_mm256_blendv_ps(velocityX, _mm256_sub_ps(velocityX, repelX),
+			_mm256_cmp_ps(positionX, boundaryMaxX, _CMP_GT_OQ)), _mm256_add_ps(velocityX, repelX),
+			_mm256_cmp_ps(positionX, boundaryMinX, _CMP_LT_OQ));
+		velocityY = _mm256_blendv_ps(_mm256_blendv_ps(velocityY, _mm256_sub_ps(velocityY, repelY),
+			_mm256_cmp_ps(positionY, boundaryMaxY, _CMP_GT_OQ)), _mm256_add_ps(velocityY, repelY),
+			_mm256_cmp_ps(positionY, boundaryMinY, _CMP_LT_OQ));
+
+		__m256 speed2 = _mm256_add_ps(_mm256_mul_ps(velocityX, velocityX), _mm256_mul_ps(velocityY, velocityY));
+		__m256 clamped = _mm256_cmp_ps(speed2, maxSpeeds2, _CMP_GE_OQ);
+		__m256 speed = _mm256_sqrt_ps(speed2);
+
+		velocityX = _mm256_blendv_ps(velocityX, _mm256_mul_ps(_mm256_div_ps(velocityX, speed), maxSpeeds), clamped);
+		velocityY = _mm256_blendv_ps(velocityY, _mm256_mul_ps(_mm256_div_ps(velocityY, speed), maxSpeeds), clamped);
+		positionX = _mm256_add_ps(positionX, _mm256_mul_ps(velocityX, dts));
+		positionY = _mm256_add_ps(positionY, _mm256_mul_ps(velocityY, dts));
+
+		_mm256_storeu_ps(x + i, positionX);
+		_mm256_storeu_ps(y + i, positionY);
+		_mm256_storeu_ps(vx + i, velocityX);
+		_mm256_storeu_ps(vy + i, velocityY);
+
+		minX = _mm256_min_ps(minX, positionX);
+		minY = _mm256_min_ps(minY, positionY);
+		maxX = _mm256_max_ps(maxX, positionX);
+		maxY = _mm256_max_ps(maxY, positionY);
+		positionTotalX = _mm256_add_ps(positionTotalX, positionX);
+		positionTotalY = _mm256_add_ps(positionTotalY, positionY);
+		velocityTotalX = _mm256_add_ps(velocityTotalX, velocityX);
+		velocityTotalY = _mm256_add_ps(velocityTotalY, velocityY);
+	}
+
+	alignas(32) float lanes[4][8];
+	_mm256_store_ps(lanes[0], minX);
+	_mm256_store_ps(lanes[1], minY);
+	_mm256_store_ps(lanes[2], maxX);
+	_mm256_store_ps(lanes[3], maxY);
+	extendByLanes(summary, lanes[0], lanes[1], lanes[2], lanes[3], 8);
+
+	summary.positionSum += Vec2f(reduceAVX2(positionTotalX), reduceAVX2(positionTotalY));
+	summary.velocitySum += Vec2f(reduceAVX2(velocityTotalX), reduceAVX2(velocityTotalY));
+
+	_mm256_zeroupper();
+
+	integrateBoidsScalar(x + i, y + i, vx + i, vy + i, count - i, dt, boundary, boundaryRepel, maxSpeed, summary);
+}
+
+SIMD_TARGET("avx512f")
+static void integrateBoidsAVX512(float* x, float* y, float* vx, float* vy, size_t count, float dt,
+	const Boundary2f& boundary, const Vec2f& boundaryRepel, float maxSpeed, IntegrationSummary& summary)
+{
+	__m512 boundaryMinX = _mm512_set1_ps(boundary.min.x);
+	__m512 boundaryMinY = _mm512_set1_ps(boundary.min.y);
+	__m512 boundaryMaxX = _mm512_set1_ps(boundary.max.x);
+	__m512 boundaryMaxY = _mm512_set1_ps(boundary.max.y);
+	__m512 repelX = _mm512_set1_ps(boundaryRepel.x);
+	__m512 repelY = _mm512_set1_ps(boundaryRepel.y);
+	__m512 maxSpeeds = _mm512_set1_ps(maxSpeed);
+	__m512 maxSpeeds2 = _mm512_set1_ps(maxSpeed * maxSpeed);
+	__m512 dts = _mm512_set1_ps(dt);
+	__m512 minX = _mm512_set1_ps(summary.bounds.min.x);
+	__m512 minY = _mm512_set1_ps(summary.bounds.min.y);
+	__m512 maxX = _mm512_set1_ps(summary.bounds.max.x);
+	__m512 maxY = _mm512_set1_ps(summary.bounds.max.y);
+	__m512 positionTotalX = _mm512_setzero_ps();
+	__m512 positionTotalY = _mm512_setzero_ps();
+	__m512 velocityTotalX = _mm512_setzero_ps();
+	__m512 velocityTotalY = _mm512_setzero_ps();
+	__mmask16 all = static_cast<__mmask16>(0xffff);
+	size_t i = 0;
+
+	for (; i + 16 <= count; i += 16)
+	{
+		__m512 positionX = _mm512_loadu_ps(x + i);
+		__m512 positionY = _mm512_loadu_ps(y + i);
+		__m512 velocityX = _mm512_loadu_ps(vx + i);
+		__m512 velocityY = _mm512_loadu_ps(vy + i);
+		__mmask16 belowX = _mm512_cmp_ps_mask(positionX, boundaryMinX, _CMP_LT_OQ);
+		__mmask16 belowY = _mm512_cmp_ps_mask(positionY, boundaryMinY, _CMP_LT_OQ);
+		__mmask16 aboveX = _mm512_mask_cmp_ps_mask(static_cast<__mmask16>(~belowX), positionX, boundaryMaxX, _CMP_GT_OQ);
+		__mmask16 aboveY = _mm512_mask_cmp_ps_mask(static_cast<__mmask16>(~belowY), positionY, boundaryMaxY, _CMP_GT_OQ);
+
+		velocityX = _mm512_mask_sub_ps(_mm512_mask_add_ps(velocityX, belowX, velocityX, repelX), aboveX, velocityX, repelX);
+		velocityY = _mm512_mask_sub_ps(_mm512_mask_add_ps(velocityY, belowY, velocityY, repelY), aboveY, velocityY, repelY);
+
+		__m512 speed2 = _mm512_add_ps(_mm512_mul_ps(velocityX, velocityX), _mm512_mul_ps(velocityY, velocityY));
+		__mmask16 clamped = _mm512_cmp_ps_mask(speed2, maxSpeeds2, _CMP_GE_OQ);
+		__m512 speed = _mm512_maskz_sqrt_ps(clamped, speed2);
+
+		velocityX = _mm512_mask_mul_ps(velocityX, clamped, _mm512_div_ps(velocityX, speed), maxSpeeds);
+		velocityY = _mm512_mask_mul_ps(velocityY, clamped, _mm512_div_ps(velocityY, speed), maxSpeeds);
+		positionX = _mm512_add_ps(positionX, _mm512_mul_ps(velocityX, dts));
+		positionY = _mm512_add_ps(positionY, _mm512_mul_ps(velocityY, dts));
+
+		_mm512_storeu_ps(x + i, positionX);
+		_mm512_storeu_ps(y + i, positionY);
+		_mm512_storeu_ps(vx + i, velocityX);
+		_mm512_storeu_ps(vy + i, velocityY);
+
+		minX = _mm512_mask_min_ps(minX, all, minX, positionX);
+		minY = _mm512_mask_min_ps(minY, all, minY, positionY);
+		maxX = _mm512_mask_max_ps(maxX, all, maxX, positionX);
+		maxY = _mm512_mask_max_ps(maxY, all, maxY, positionY);
+		positionTotalX = _mm512_add_ps(positionTotalX, positionX);
+		positionTotalY = _mm512_add_ps(positionTotalY, positionY);
+		velocityTotalX = _mm512_add_ps(velocityTotalX, velocityX);
+		velocityTotalY = _mm512_add_ps(velocityTotalY, velocityY);
+	}
+
+	alignas(64) float lanes[4][16];
+	_mm512_store_ps(lanes[0], minX);
+	_mm512_store_ps(lanes[1], minY);
+	_mm512_store_ps(lanes[2], maxX);
+	_mm512_store_ps(lanes[3], maxY);
+	extendByLanes(summary, lanes[0], lanes[1], lanes[2], lanes[3], 16);
+
+	summary.positionSum += Vec2f(reduceAVX512(positionTotalX), reduceAVX512(positionTotalY));
+	summary.velocitySum += Vec2f(reduceAVX512(velocityTotalX), reduceAVX512(velocityTotalY));
+
+	_mm256_zeroupper();
+
+	integrateBoidsScalar(x + i, y + i, vx + i, vy + i, count - i, dt, boundary, boundaryRepel, maxSpeed, summary);
+}
+
+#endif
+
+size_t filterNear(SimdLevel level, const float* x, const float* y, const GroupId* groups, const float* searchDistances2,
+	float px, float py, uint32_t begin, uint32_t end, uint32_t* out)
+{
+#ifdef SIMD_X86
+	switch (level)
+	{
+	case SimdLevel::AVX512:
+		return filterNearAVX512(x, y, groups, searchDistances2, px, py, begin, end, out);
+	case SimdLevel::AVX2:
+		return filterNearAVX2(x, y, groups, searchDistances2, px, py, begin, end, out);
+	case SimdLevel::SSE2:
+		return filterNearSSE2(x, y, groups, searchDistances2, px, py, begin, end, out);
+	case SimdLevel::Scalar:
+		break;
+	}
+#endif
+
+	return filterNearScalar(x, y, groups, searchDistances2, px, py, begin, end, out);
+}
+
+size_t accumulateNeighbors(const KernelOptions& options, const float* x, const float* y, const float* vx, const float* vy,
+	const GroupId* groups, const float* viewDistances2, const uint32_t* neighbors, size_t count, float px, float py,
+	float minDistance2, float* sums)
+{
+#ifdef SIMD_X86
+	switch (options.simdLevel)
+	{
+	case SimdLevel::AVX512:
+		return accumulateNeighborsAVX512(options.fastReciprocal, x, y, vx, vy, groups, viewDistances2, neighbors, count,
+			px, py, minDistance2, sums);
+	case SimdLevel::AVX2:
+		return accumulateNeighborsAVX2(options.fastReciprocal, x, y, vx, vy, groups, viewDistances2, neighbors, count,
+			px, py, minDistance2, sums);
+	case SimdLevel::SSE2:
+		return accumulateNeighborsSSE2(options.fastReciprocal, x, y, vx, vy, groups, viewDistances2, neighbors, count,
+			px, py, minDistance2, sums);
+	case SimdLevel::Scalar:
+		break;
+	}
+#endif
+
+	return accumulateNeighborsScalar(x, y, vx, vy, groups, viewDistances2, neighbors, count, px, py, minDistance2, sums);
+}
+
+void integrateBoids(SimdLevel level, float* x, float* y, float* vx, float* vy, size_t count, float dt,
+	const Boundary2f& boundary, const Vec2f& boundaryRepel, float maxSpeed, IntegrationSummary& summary)
+{
+#ifdef SIMD_X86
+	switch (level)
+	{
+	case SimdLevel::AVX512:
+		integrateBoidsAVX512(x, y, vx, vy, count, dt, boundary, boundaryRepel, maxSpeed, summary);
+		return;
+	case SimdLevel::AVX2:
+		integrateBoidsAVX2(x, y, vx, vy, count, dt, boundary, boundaryRepel, maxSpeed, summary);
+		return;
+	case SimdLevel::SSE2:
+		integrateBoidsSSE2(x, y, vx, vy, count, dt, boundary, boundaryRepel, maxSpeed, summary);
+		return;
+	case SimdLevel::Scalar:
+		break;
+	}
+#endif
+
+	integrateBoidsScalar(x, y, vx, vy, count, dt, boundary, boundaryRepel, maxSpeed, summary);
+}
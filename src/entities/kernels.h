@@ -0,0 +1,64 @@
+#pragma once
+
+#include "../utils/cpu.h"
+#include "../utils/vecmath.h"
+#include <cstdint>
+#include <cstddef>
+
+/************************************************************************************************************
+* SIMD versions of the inner loops, one per SimdLevel, picked at run time by the level passed in.
+* Every version computes the same operations in the same order as the scalar one, lane by lane and without
+* fused multiply-adds, so they all give the same result bit for bit, unless noted otherwise.
+*************************************************************************************************************/
+
+// group of a boid as the grid stores it next to every entry, a byte so that a scan over the entries
+// reads little more than the positions; a system holds at most MAX_GROUPS groups
+typedef uint8_t GroupId;
+const size_t MAX_GROUPS = 256;
+
+/************************************************************************************************************
+* Which kernels run and how precisely.
+*************************************************************************************************************/
+struct KernelOptions
+{
+	KernelOptions();
+
+	// the best level of the processor by default
+	SimdLevel simdLevel;
+	// the SIMD steering kernels replace a division by a reciprocal estimate refined by one Newton step
+	bool fastReciprocal;
+};
+
+/************************************************************************************************************
+* What integrateBoids learns about the boids it moved, merged over the chunks of a group.
+*************************************************************************************************************/
+struct IntegrationSummary
+{
+	IntegrationSummary();
+
+	void merge(const IntegrationSummary& other);
+
+	// box around the integrated positions, inverted (min > max) while nothing was integrated
+	Boundary2f bounds;
+	Vec2f positionSum;
+	Vec2f velocitySum;
+};
+
+// writes the entries i in [begin, end) with (px - x[i])^2 + (py - y[i])^2 <= searchDistances2[groups[i]] to out,
+// in order, and returns how many there are; out needs room for end - begin + SIMD_WIDTH indices
+size_t filterNear(SimdLevel level, const float* x, const float* y, const GroupId* groups, const float* searchDistances2,
+	float px, float py, uint32_t begin, uint32_t end, uint32_t* out);
+
+// adds the count neighbors of a boid at (px, py) that are within the view distance of their group, all of them
+// when viewDistances2 is null, to sums: positions to sums[0..1], separations dx / (distance^2 / minDistance2)
+// to sums[2..3] and velocities to sums[4..5]; returns how many were added. The SIMD versions add the neighbors
+// in a different order, so their sums may differ from the scalar ones in the last bits.
+size_t accumulateNeighbors(const KernelOptions& options, const float* x, const float* y, const float* vx, const float* vy,
+	const GroupId* groups, const float* viewDistances2, const uint32_t* neighbors, size_t count, float px, float py,
+	float minDistance2, float* sums);
+
+// moves the count boids one step of dt in place: pushes the boids outside the boundary back by boundaryRepel,
+// clamps their speed to maxSpeed, advances their positions and adds them to summary. The SIMD versions add the
+// positions and velocities to the sums in a different order, the boids themselves move the same bit for bit.
+void integrateBoids(SimdLevel level, float* x, float* y, float* vx, float* vy, size_t count, float dt,
+	const Boundary2f& boundary, const Vec2f& boundaryRepel, float maxSpeed, IntegrationSummary& summary);
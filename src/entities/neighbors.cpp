@@ -0,0 +1,122 @@
+#include "neighbors.h"
+#include <algorithm>
+
+/************************************************************************************************************
+*											NeighborSpan
+*************************************************************************************************************/
+
+NeighborSpan::NeighborSpan()
+{
+	first = nullptr;
+	last = nullptr;
+}
+
+NeighborSpan::NeighborSpan(const uint32_t* begin, const uint32_t* end)
+{
+	first = begin;
+	last = end;
+}
+
+const uint32_t* NeighborSpan::begin() const
+{
+	return first;
+}
+
+const uint32_t* NeighborSpan::end() const
+{
+	return last;
+}
+
+size_t NeighborSpan::size() const
+{
+	return last - first;
+}
+
+bool NeighborSpan::empty() const
+{
+	return first == last;
+}
+
+/************************************************************************************************************
+*											NeighborTable
+*************************************************************************************************************/
+
+NeighborTable::NeighborTable()
+{
+	m_Offsets.assign(1, 0);
+}
+
+size_t NeighborTable::getBoidCount() const
+{
+	return m_LocalLists.size();
+}
+
+size_t NeighborTable::getNeighborCount() const
+{
+	return m_Offsets.back();
+}
+
+NeighborSpan NeighborTable::getFriendly(size_t boid) const
+{
+	const uint32_t* indices = m_Indices.data();
+
+	return NeighborSpan(indices + m_Offsets[2 * boid], indices + m_Offsets[2 * boid + 1]);
+}
+
+NeighborSpan NeighborTable::getStrangers(size_t boid) const
+{
+	const uint32_t* indices = m_Indices.data();
+
+	return NeighborSpan(indices + m_Offsets[2 * boid + 1], indices + m_Offsets[2 * boid + 2]);
+}
+
+void NeighborTable::reset(size_t boidCount, size_t workerCount)
+{
+	m_LocalLists.resize(boidCount);
+	m_WorkerBuffers.resize(workerCount);
+
+	for (size_t i = 0; i < m_WorkerBuffers.size(); i++)
+	{
+		m_WorkerBuffers[i].clear();
+	}
+}
+
+std::vector<uint32_t>& NeighborTable::getWorkerBuffer(size_t worker)
+{
+	return m_WorkerBuffers[worker];
+}
+
+void NeighborTable::addList(size_t boid, size_t worker, size_t begin, size_t friendlyCount, size_t strangerCount)
+{
+	LocalList& list = m_LocalLists[boid];
+
+	list.worker = static_cast<uint32_t>(worker);
+	list.begin = static_cast<uint32_t>(begin);
+	list.friendlyCount = static_cast<uint32_t>(friendlyCount);
+	list.strangerCount = static_cast<uint32_t>(strangerCount);
+}
+
+void NeighborTable::commit()
+{
+	m_Offsets.resize(2 * m_LocalLists.size() + 1);
+	m_Offsets[0] = 0;
+
+	for (size_t i = 0; i < m_LocalLists.size(); i++)
+	{
+		m_Offsets[2 * i + 1] = m_Offsets[2 * i] + m_LocalLists[i].friendlyCount;
+		m_Offsets[2 * i + 2] = m_Offsets[2 * i + 1] + m_LocalLists[i].strangerCount;
+	}
+
+	m_Indices.resize(m_Offsets.back());
+}
+
+void NeighborTable::compact(size_t begin, size_t end)
+{
+	for (size_t i = begin; i < end; i++)
+	{
+		const LocalList& list = m_LocalLists[i];
+		const uint32_t* source = m_WorkerBuffers[list.worker].data() + list.begin;
+
+		std::copy(source, source + list.friendlyCount + list.strangerCount, m_Indices.data() + m_Offsets[2 * i]);
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/************************************************************************************************************
+* Read-only view of a run of neighbor indices.
+*************************************************************************************************************/
+struct NeighborSpan
+{
+	NeighborSpan();
+	NeighborSpan(const uint32_t* begin, const uint32_t* end);
+
+	const uint32_t* begin() const;
+	const uint32_t* end() const;
+	size_t size() const;
+	bool empty() const;
+
+	const uint32_t* first;
+	const uint32_t* last;
+};
+
+/************************************************************************************************************
+* Neighbor lists of every boid of a tick in compressed sparse row form: one offsets array and one index array.
+* The list of boid b is split in two segments, friendly boids in [offsets[2b], offsets[2b + 1]) and
+* strangers in [offsets[2b + 1], offsets[2b + 2]). Indices refer to entries of the SpatialGrid.
+*
+* Workers gather into their own buffers first (addList), then commit() lays out the offsets and compact()
+* copies each list into place. Every buffer keeps its capacity, so a steady state tick does not allocate.
+*************************************************************************************************************/
+class NeighborTable
+{
+public:
+	NeighborTable();
+
+	size_t getBoidCount() const;
+	size_t getNeighborCount() const;
+
+	NeighborSpan getFriendly(size_t boid) const;
+	NeighborSpan getStrangers(size_t boid) const;
+
+	void reset(size_t boidCount, size_t workerCount);
+
+	std::vector<uint32_t>& getWorkerBuffer(size_t worker);
+	void addList(size_t boid, size_t worker, size_t begin, size_t friendlyCount, size_t strangerCount);
+
+	void commit();
+	void compact(size_t begin, size_t end);
+
+private:
+	struct LocalList
+	{
+		uint32_t worker;
+		uint32_t begin;
+		uint32_t friendlyCount;
+		uint32_t strangerCount;
+	};
+
+	std::vector<uint32_t> m_Offsets;
+	std::vector<uint32_t> m_Indices;
+
+	std::vector<LocalList> m_LocalLists;
+	std::vector<std::vector<uint32_t>> m_WorkerBuffers;
+};
@@ -0,0 +1,266 @@
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <ctime>
+#include <cstdlib>
+#include <iostream>
+
+#include "../utils/vecmath.h"
+#include "../entities/boid.h"
+
+/************************************************************************************************************
+* Runs the simulation without a window and reports its throughput.
+*************************************************************************************************************/
+
+struct HeadlessOptions
+{
+	HeadlessOptions();
+
+	size_t groups;
+	size_t boids;
+	size_t ticks;
+	float dt;
+	size_t threads;
+	Vec2f size;
+	CellOrder cellOrder;
+	bool reorder;
+	float skin;
+	bool pairwise;
+	bool meanField;
+	float meanFieldError;
+	SimdLevel simdLevel;
+	bool fastReciprocal;
+	size_t nearest;
+	unsigned int seed;
+};
+
+HeadlessOptions::HeadlessOptions()
+{
+	groups = 3;
+	boids = 1000;
+	ticks = 1000;
+	dt = 1.0f / 60.0f;
+	threads = std::thread::hardware_concurrency();
+	size = Vec2f(1080.0f, 720.0f);
+	cellOrder = CellOrder::RowMajor;
+	reorder = false;
+	skin = 0.0f;
+	pairwise = false;
+	meanField = false;
+	meanFieldError = 0.5f;
+	simdLevel = detectSimdLevel();
+	fastReciprocal = false;
+	nearest = 0;
+	seed = static_cast<unsigned int>(time(nullptr));
+}
+
+void printUsage(const char* program)
+{
+	std::cout << "usage: " << program << " [options]\n"
+		<< "  --groups N     number of boid groups, at most " << MAX_GROUPS << " (default 3)\n"
+		<< "  --boids N      boids per group (default 1000)\n"
+		<< "  --ticks N      simulation ticks to run (default 1000)\n"
+		<< "  --dt S         seconds per tick (default 1/60)\n"
+		<< "  --threads N    worker threads (default: hardware concurrency)\n"
+		<< "  --width W      boundary width (default 1080)\n"
+		<< "  --height H     boundary height (default 720)\n"
+		<< "  --order O      cell order of the grid: row, morton or hilbert (default row)\n"
+		<< "  --reorder 0|1  sort the boids into cell order every tick (default 0)\n"
+		<< "  --nearest K    steer by the K nearest boids instead of the view distance (default 0: view distance)\n"
+		<< "  --pairs 0|1    visit every pair of boids once and steer both (default 0)\n"
+		<< "  --skin D       keep the neighbor lists until a boid moves D/2, 0 rebuilds them every tick (default 0)\n"
+		<< "  --mean-field T add cells of size <= T * distance as their aggregates (default: exact)\n"
+		<< "  --simd S       scalar, sse2, avx2 or avx512, capped at what the processor has (default: best)\n"
+		<< "  --fast-rcp 0|1 estimate the separation reciprocal in the SIMD steering kernels (default 0)\n"
+		<< "  --seed N       random seed (default: time)\n";
+}
+
+bool parseCellOrder(const std::string& value, CellOrder& order)
+{
+	if (value == "row")
+	{
+		order = CellOrder::RowMajor;
+	}
+	else if (value == "morton")
+	{
+		order = CellOrder::Morton;
+	}
+	else if (value == "hilbert")
+	{
+		order = CellOrder::Hilbert;
+	}
+	else
+	{
+		std::cerr << "unknown cell order " << value << "\n";
+		return false;
+	}
+
+	return true;
+}
+
+bool parseOptions(int argc, char** argv, HeadlessOptions& options)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+
+		if (arg == "--help" || arg == "-h")
+		{
+			return false;
+		}
+
+		if (i + 1 >= argc)
+		{
+			std::cerr << "missing value for " << arg << "\n";
+			return false;
+		}
+
+		const char* value = argv[++i];
+
+		if (arg == "--groups")
+		{
+			options.groups = std::strtoul(value, nullptr, 10);
+
+			if (options.groups > MAX_GROUPS)
+			{
+				std::cerr << "at most " << MAX_GROUPS << " groups\n";
+				return false;
+			}
+		}
+		else if (arg == "--boids")
+		{
+			options.boids = std::strtoul(value, nullptr, 10);
+		}
+		else if (arg == "--ticks")
+		{
+			options.ticks = std::strtoul(value, nullptr, 10);
+		}
+		else if (arg == "--dt")
+		{
+			options.dt = std::strtof(value, nullptr);
+		}
+		else if (arg == "--threads")
+		{
+			options.threads = std::strtoul(value, nullptr, 10);
+		}
+		else if (arg == "--width")
+		{
+			options.size.x = std::strtof(value, nullptr);
+		}
+		else if (arg == "--height")
+		{
+			options.size.y = std::strtof(value, nullptr);
+		}
+		else if (arg == "--order")
+		{
+			if (!parseCellOrder(value, options.cellOrder))
+			{
+				return false;
+			}
+		}
+		else if (arg == "--reorder")
+		{
+			options.reorder = std::strtoul(value, nullptr, 10) != 0;
+		}
+		else if (arg == "--nearest")
+		{
+			options.nearest = std::strtoul(value, nullptr, 10);
+		}
+		else if (arg == "--pairs")
+		{
+			options.pairwise = std::strtoul(value, nullptr, 10) != 0;
+		}
+		else if (arg == "--skin")
+		{
+			options.skin = std::strtof(value, nullptr);
+		}
+		else if (arg == "--mean-field")
+		{
+			options.meanField = true;
+			options.meanFieldError = std::strtof(value, nullptr);
+		}
+		else if (arg == "--simd")
+		{
+			if (!parseSimdLevel(value, options.simdLevel))
+			{
+				std::cerr << "unknown instruction set " << value << "\n";
+				return false;
+			}
+		}
+		else if (arg == "--fast-rcp")
+		{
+			options.fastReciprocal = std::strtoul(value, nullptr, 10) != 0;
+		}
+		else if (arg == "--seed")
+		{
+			options.seed = static_cast<unsigned int>(std::strtoul(value, nullptr, 10));
+		}
+		else
+		{
+			std::cerr << "unknown option " << arg << "\n";
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	HeadlessOptions options;
+
+	if (!parseOptions(argc, argv, options))
+	{
+		printUsage(argv[0]);
+		return 1;
+	}
+
+	srand(options.seed);
+
+	BoidSystem boidSystem;
+	boidSystem.setBoidBoundary(Boundary2f(Vec2f(0.0f, 0.0f), options.size));
+	boidSystem.setBoidBoundaryRepel(Vec2f(15.0f, 15.0f));
+	boidSystem.setThreadCount(options.threads);
+	boidSystem.setCellOrder(options.cellOrder);
+	boidSystem.setReordering(options.reorder);
+	boidSystem.setNeighborSkin(options.skin);
+	boidSystem.setPairwise(options.pairwise);
+	boidSystem.setMeanField(options.meanField);
+	boidSystem.setMeanFieldError(options.meanFieldError);
+	boidSystem.setSimdLevel(options.simdLevel);
+	boidSystem.setFastReciprocal(options.fastReciprocal);
+
+	// same parameters as the groups main.cpp starts with
+	for (size_t i = 0; i < options.groups; i++)
+	{
+		BoidGroup& boidGroup = *boidSystem.addGroup(options.boids);
+		boidGroup.setBoidSize(Vec2f(15.0f, 5.0f));
+		boidGroup.setBoidFriendliness(0.1f);
+		boidGroup.setBoidViewDistance(60.0f);
+		boidGroup.setBoidMinSeparationDistance(15.0f);
+		boidGroup.setBoidMaxSpeed(100.0f);
+		boidGroup.setNearestCount(options.nearest);
+	}
+
+	size_t boidCount = options.groups * options.boids;
+
+	std::cout << "groups: " << options.groups << ", boids: " << boidCount << ", threads: " << boidSystem.getThreadCount()
+		<< ", ticks: " << options.ticks << ", dt: " << options.dt << "\n";
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	for (size_t i = 0; i < options.ticks; i++)
+	{
+		boidSystem.update(options.dt);
+	}
+
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	double seconds = elapsed.count();
+
+	std::cout << "elapsed: " << to_stringn(seconds, 3) << " s\n"
+		<< "ticks/sec: " << to_stringn(options.ticks / seconds, 2) << "\n"
+		<< "boid-updates/sec: " << to_stringn(static_cast<double>(options.ticks) * boidCount / seconds, 0) << "\n";
+
+	return 0;
+}
@@ -1,4 +1,5 @@
 #include "interface.h"
+#include <algorithm>
 
 GLuint Slider::m_SliderList = 0;
 GLuint Slider::m_ButtonList = 0;
@@ -12,7 +13,10 @@ Slider::Slider()
 
 	m_ButtonGrabbed = false;
 
-	m_ValuePtr = nullptr;
+	m_Value = 0.5f;
+	m_BoidSystemPtr = nullptr;
+	m_Group = 0;
+	m_Parameter = GroupParameter::Cohesion;
 }
 
 void Slider::setRange(float min, float max)
@@ -72,11 +76,24 @@ void Slider::setButtonColor(const Vec4f& color)
 	m_ButtonColor = color;
 }
 
-void Slider::setValueRef(float* valuePtr)
+void Slider::setTarget(BoidSystem* boidSystem, size_t group, GroupParameter parameter)
 {
-	m_ValuePtr = valuePtr;
+	m_BoidSystemPtr = boidSystem;
+	m_Group = group;
+	m_Parameter = parameter;
 
-	resetValue();
+	// the group already has the value the slider was set from
+	m_Value = m_Min + (m_Max - m_Min) * m_Percent;
+}
+
+float Slider::getValue() const
+{
+	return m_Value;
+}
+
+const float* Slider::getValuePtr() const
+{
+	return &m_Value;
 }
 
 void Slider::check(const Vec2f& mousePosition, int state)
@@ -176,9 +193,18 @@ void Slider::initModels()
 
 void Slider::resetValue()
 {
-	if (m_ValuePtr)
+	float value = m_Min + (m_Max - m_Min) * m_Percent;
+
+	// a held button posts nothing until it moves
+	if (value == m_Value)
+	{
+		return;
+	}
+	m_Value = value;
+
+	if (m_BoidSystemPtr)
 	{
-		*m_ValuePtr = m_Min + (m_Max - m_Min) * m_Percent;
+		m_BoidSystemPtr->postChange(ParameterChange(m_Group, m_Parameter, m_Value));
 	}
 }
 
@@ -245,7 +271,7 @@ void TextBox::setValueRef(std::string* textPtr)
 	m_FromValue = false;
 }
 
-void TextBox::setValueRef(float* valuePtr)
+void TextBox::setValueRef(const float* valuePtr)
 {
 	m_ValuePtr = valuePtr;
 	m_FromValue = true;
@@ -653,89 +679,92 @@ void UserInterface::setMouseStatsPtr(MouseStats* mouseStatsPtr)
 	m_MouseStatsPtr = mouseStatsPtr;
 }
 
-void UserInterface::setBoidGroupStats(BoidGroup* boidGroup)
+void UserInterface::setBoidGroupStats(size_t group)
 {
+	// the sliders post their changes to the system, the text boxes show the values of the sliders
+	BoidGroup* boidGroup = &m_BoidSystemPtr->getGroup(group);
 	size_t k = 0;
 	m_PreviewBoidPtr = boidGroup;
+	m_PreviewBoid = BoidHandle();
 
 	//cohesion
 	m_Sliders[k].setPercentFromValue(*boidGroup->getBoidCohesion());
-	m_Sliders[k].setValueRef(boidGroup->getBoidCohesion());
+	m_Sliders[k].setTarget(m_BoidSystemPtr, group, GroupParameter::Cohesion);
 
 	m_TextBoxes[k].setPrecision(2);
-	m_TextBoxes[k].setValueRef(boidGroup->getBoidCohesion());
+	m_TextBoxes[k].setValueRef(m_Sliders[k].getValuePtr());
 	k++; 
 
 	//separation
 	m_Sliders[k].setPercentFromValue(*boidGroup->getBoidSeparation());
-	m_Sliders[k].setValueRef(boidGroup->getBoidSeparation());
+	m_Sliders[k].setTarget(m_BoidSystemPtr, group, GroupParameter::Separation);
 
 	m_TextBoxes[k].setPrecision(2);
-	m_TextBoxes[k].setValueRef(boidGroup->getBoidSeparation());
+	m_TextBoxes[k].setValueRef(m_Sliders[k].getValuePtr());
 	k++;
 
 	//alignment
 	m_Sliders[k].setPercentFromValue(*boidGroup->getBoidAlignment());
-	m_Sliders[k].setValueRef(boidGroup->getBoidAlignment());
+	m_Sliders[k].setTarget(m_BoidSystemPtr, group, GroupParameter::Alignment);
 
 	m_TextBoxes[k].setPrecision(2);
-	m_TextBoxes[k].setValueRef(boidGroup->getBoidAlignment());
+	m_TextBoxes[k].setValueRef(m_Sliders[k].getValuePtr());
 	k++;
 
 	//friendliness
 	m_Sliders[k].setPercentFromValue(*boidGroup->getFriendliness());
-	m_Sliders[k].setValueRef(boidGroup->getFriendliness());
+	m_Sliders[k].setTarget(m_BoidSystemPtr, group, GroupParameter::Friendliness);
 
 	m_TextBoxes[k].setPrecision(2);
-	m_TextBoxes[k].setValueRef(boidGroup->getFriendliness());
+	m_TextBoxes[k].setValueRef(m_Sliders[k].getValuePtr());
 	k++;
 
 	//size.x
 	m_Sliders[k].setPercentFromValue(boidGroup->getBoidSize().x);
-	m_Sliders[k].setValueRef(&boidGroup->getBoidSize().x);
+	m_Sliders[k].setTarget(m_BoidSystemPtr, group, GroupParameter::Width);
 
 	m_TextBoxes[k].setPrecision(1);
-	m_TextBoxes[k].setValueRef(&boidGroup->getBoidSize().x);
+	m_TextBoxes[k].setValueRef(m_Sliders[k].getValuePtr());
 	k++;
 
 	//size.y
 	m_Sliders[k].setPercentFromValue(boidGroup->getBoidSize().y);
-	m_Sliders[k].setValueRef(&boidGroup->getBoidSize().y);
+	m_Sliders[k].setTarget(m_BoidSystemPtr, group, GroupParameter::Height);
 
 	m_TextBoxes[k].setPrecision(1);
-	m_TextBoxes[k].setValueRef(&boidGroup->getBoidSize().y);
+	m_TextBoxes[k].setValueRef(m_Sliders[k].getValuePtr());
 	k++;
 
 	//count
 	m_Sliders[k].setPercentFromValue(*boidGroup->getCount());
-	m_Sliders[k].setValueRef(boidGroup->getCount());
+	m_Sliders[k].setTarget(m_BoidSystemPtr, group, GroupParameter::Count);
 
 	m_TextBoxes[k].setPrecision(0);
-	m_TextBoxes[k].setValueRef(boidGroup->getCount());
+	m_TextBoxes[k].setValueRef(m_Sliders[k].getValuePtr());
 	k++;
 
 	//R
 	m_Sliders[k].setPercentFromValue(boidGroup->getBoidColor().x);
-	m_Sliders[k].setValueRef(&boidGroup->getBoidColor().x);
+	m_Sliders[k].setTarget(m_BoidSystemPtr, group, GroupParameter::ColorR);
 
 	m_TextBoxes[k].setPrecision(2);
-	m_TextBoxes[k].setValueRef(&boidGroup->getBoidColor().x);
+	m_TextBoxes[k].setValueRef(m_Sliders[k].getValuePtr());
 	k++;
 
 	//G
 	m_Sliders[k].setPercentFromValue(boidGroup->getBoidColor().y);
-	m_Sliders[k].setValueRef(&boidGroup->getBoidColor().y);
+	m_Sliders[k].setTarget(m_BoidSystemPtr, group, GroupParameter::ColorG);
 
 	m_TextBoxes[k].setPrecision(2);
-	m_TextBoxes[k].setValueRef(&boidGroup->getBoidColor().y);
+	m_TextBoxes[k].setValueRef(m_Sliders[k].getValuePtr());
 	k++;
 
 	//B
 	m_Sliders[k].setPercentFromValue(boidGroup->getBoidColor().z);
-	m_Sliders[k].setValueRef(&boidGroup->getBoidColor().z);
+	m_Sliders[k].setTarget(m_BoidSystemPtr, group, GroupParameter::ColorB);
 
 	m_TextBoxes[k].setPrecision(2);
-	m_TextBoxes[k].setValueRef(&boidGroup->getBoidColor().z);
+	m_TextBoxes[k].setValueRef(m_Sliders[k].getValuePtr());
 	k++;
 }
 
@@ -776,10 +805,10 @@ void UserInterface::check()
 		for (size_t i = 0; i < boidGroups.size(); i++)
 		{
 			count = 0;
-			std::vector <Boid>& boids = boidGroups[i].getBoids();
+			const BoidArray& boids = boidGroups[i].getBoids();
 			for (size_t j = 0; j < boids.size(); j++)
 			{
-				if (m_SelectionBox.m_SelectionBoundary.contains(boids[j].getPosition()))
+				if (m_SelectionBox.m_SelectionBoundary.contains(boids.getPosition(j)))
 				{
 					count++;
 				}
@@ -794,7 +823,7 @@ void UserInterface::check()
 		if (max)
 		{
 			m_Active = true;
-			setBoidGroupStats(&m_BoidSystemPtr->getGroup(index));
+			setBoidGroupStats(index);
 		}
 	}
 
@@ -875,18 +904,25 @@ void UserInterface::draw()
 
 	glTranslatef(m_Padding.x, m_Padding.y, 0.0f);
 
-	if (m_PreviewBoidPtr)
+	// follows one boid wherever reordering moves it, and picks another once it is despawned
+	if (m_PreviewBoidPtr && !m_PreviewBoidPtr->isAlive(m_PreviewBoid) && m_PreviewBoidPtr->getLiveCount())
+	{
+		for (size_t i = 0; !m_PreviewBoidPtr->isAlive(m_PreviewBoid); i++)
+		{
+			m_PreviewBoid = m_PreviewBoidPtr->getBoidHandle(i);
+		}
+	}
+
+	if (m_PreviewBoidPtr && m_PreviewBoidPtr->isAlive(m_PreviewBoid))
 	{
-		Boid& boid = m_PreviewBoidPtr->getBoids()[0];
-		Vec2f boidPosition = boid.getPosition();
+		Boid boid = m_PreviewBoidPtr->getBoids()[m_PreviewBoidPtr->getBoidIndex(m_PreviewBoid)];
 		boid.setPosition(Vec2f(0.0f, 0.0f));
 		
 		glPushMatrix();
 
 		glTranslatef(430.0f, 340.0f, 0.0f);
 		glScalef(3.0f, 3.0f, 1.0f);
-		boid.draw(m_PreviewBoidPtr->getBoidModel(), m_PreviewBoidPtr->getBoidSize(), m_PreviewBoidPtr->getBoidColor());
-		boid.setPosition(boidPosition);
+		BoidRenderer::drawBoid(boid, m_PreviewBoidPtr->getBoidSize(), m_PreviewBoidPtr->getBoidColor());
 
 		glPopMatrix();
 	}
@@ -934,3 +970,115 @@ void UserInterface::setBoidSystemRef(BoidSystem& boidSystem)
 {
 	m_BoidSystemPtr = &boidSystem;
 }
+
+
+// name padded to 18 characters, then average and maximum in ms right-aligned in 8 each
+static std::string formatTimingLine(const char* name, double average, double max)
+{
+	std::string line = name;
+	std::string averageText = to_stringn(average * 1000.0, 2);
+	std::string maxText = to_stringn(max * 1000.0, 2);
+
+	line.resize(18, ' ');
+	line += std::string(8 - std::min<size_t>(averageText.size(), 8), ' ') + averageText;
+	line += std::string(8 - std::min<size_t>(maxText.size(), 8), ' ') + maxText;
+
+	return line;
+}
+
+ProfilerOverlay::ProfilerOverlay()
+{
+	m_Padding = Vec2f(8.0f, 6.0f);
+	m_TextColor = Vec4f(1.0f, 1.0f, 1.0f);
+	m_BoxColor = Vec4f(0.1f, 0.1f, 0.1f, 0.6f);
+	m_Active = false;
+}
+
+Vec2f ProfilerOverlay::getSize() const
+{
+	// GLUT_BITMAP_8_BY_13, one line every 16 pixels
+	return Vec2f(8.0f * m_LineLength, 16.0f * m_LineCount) + m_Padding * 2.0f;
+}
+
+bool ProfilerOverlay::isActive() const
+{
+	return m_Active;
+}
+
+void ProfilerOverlay::setActive(bool value)
+{
+	m_Active = value;
+}
+
+void ProfilerOverlay::setPosition(const Vec2f& position)
+{
+	m_Position = position;
+}
+
+void ProfilerOverlay::setTextColor(const Vec4f& color)
+{
+	m_TextColor = color;
+}
+
+void ProfilerOverlay::setBoxColor(const Vec4f& color)
+{
+	m_BoxColor = color;
+}
+
+void ProfilerOverlay::draw(const FrameProfiler& profiler, const BoidSystem& boidSystem)
+{
+	if (!m_Active)
+	{
+		return;
+	}
+
+	Vec2f size = getSize();
+
+	glColorVec4f(m_BoxColor);
+	glBegin(GL_QUADS);
+	glVertexVec2f(m_Position);
+	glVertexVec2f(m_Position + Vec2f(size.x, 0.0f));
+	glVertexVec2f(m_Position + size);
+	glVertexVec2f(m_Position + Vec2f(0.0f, size.y));
+	glEnd();
+
+	Vec2f position = m_Position + m_Padding;
+	Vec2f line(0.0f, 16.0f);
+
+	std::string text = "stage               avg ms  max ms";
+	drawText(position, text, m_TextColor);
+	position += line;
+
+	for (int i = 0; i < FrameProfiler::StageCount; i++)
+	{
+		FrameProfiler::Stage stage = static_cast<FrameProfiler::Stage>(i);
+
+		text = formatTimingLine(FrameProfiler::getStageName(stage), profiler.getAverage(stage), profiler.getMax(stage));
+		drawText(position, text, m_TextColor);
+		position += line;
+	}
+
+	double frameAverage = profiler.getFrameAverage();
+
+	text = formatTimingLine("frame", frameAverage, profiler.getFrameMax());
+	drawText(position, text, m_TextColor);
+	position += line;
+
+	text = "fps: " + to_stringn(frameAverage > 0.0 ? 1.0 / frameAverage : 0.0, 1);
+	drawText(position, text, m_TextColor);
+	position += line;
+
+	const UpdateStats& stats = boidSystem.getUpdateStats();
+	double neighborAverage = stats.boidCount ? static_cast<double>(stats.neighborCount) / stats.boidCount : 0.0;
+
+	text = "boids: " + std::to_string(stats.boidCount) + "  threads: " + std::to_string(boidSystem.getThreadCount());
+	drawText(position, text, m_TextColor);
+	position += line;
+
+	text = "neighbors: avg " + to_stringn(neighborAverage, 1) + "  max " + std::to_string(stats.maxNeighbors);
+	drawText(position, text, m_TextColor);
+	position += line;
+
+	text = "neighbor pairs: " + std::to_string(stats.neighborCount) + (stats.neighborsRebuilt ? "  rebuilt" : "  kept");
+	drawText(position, text, m_TextColor);
+}
\ No newline at end of file
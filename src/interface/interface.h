@@ -2,6 +2,8 @@
 
 #include "../utils/utils.h"
 #include "../entities/boid.h"
+#include "../render/renderer.h"
+#include "../utils/profiler.h"
 #include <vector>
 #include <string>
 
@@ -20,8 +22,11 @@ public:
 	void setButtonDiameterPercent(float percent);
 	void setSliderColor(const Vec4f& color);
 	void setButtonColor(const Vec4f& color);
-	
-	void setValueRef(float* valuePtr);
+
+	// every move of the slider posts its value to boidSystem as a change of parameter of group
+	void setTarget(BoidSystem* boidSystem, size_t group, GroupParameter parameter);
+	float getValue() const;
+	const float* getValuePtr() const;
 
 	void check(const Vec2f& mousePosition, int state);
 
@@ -36,7 +41,10 @@ private:
 	void resetValue();
 
 private:
-	float* m_ValuePtr;
+	float m_Value;
+	BoidSystem* m_BoidSystemPtr;
+	size_t m_Group;
+	GroupParameter m_Parameter;
 
 	float m_Min;
 	float m_Max;
@@ -72,7 +80,7 @@ public:
 	void setText(const std::string& string);
 
 	void setValueRef(std::string* textPtr);
-	void setValueRef(float* valuePtr);
+	void setValueRef(const float* valuePtr);
 
 	void useFloat(bool value);
 
@@ -85,7 +93,7 @@ public:
 
 private:
 	std::string* m_TextPtr;
-	float* m_ValuePtr;
+	const float* m_ValuePtr;
 	std::string m_Text;
 
 	Vec2f m_Position;
@@ -192,7 +200,7 @@ public:
 
 	void setMouseStatsPtr(MouseStats* mouseStatsPtr);
 
-	void setBoidGroupStats(BoidGroup* boidGroup);
+	void setBoidGroupStats(size_t group);
 	
 	void setActive(bool value);
 
@@ -229,4 +237,36 @@ private:
 	BoidSystem* m_BoidSystemPtr;
 
 	BoidGroup* m_PreviewBoidPtr;
+	BoidHandle m_PreviewBoid;
+};
+
+/************************************************************************************************************
+* Text panel with the rolling stage timings of a FrameProfiler and the neighbor statistics of the last update.
+*************************************************************************************************************/
+class ProfilerOverlay
+{
+public:
+	ProfilerOverlay();
+
+	Vec2f getSize() const;
+
+	bool isActive() const;
+	void setActive(bool value);
+
+	void setPosition(const Vec2f& position);
+	void setTextColor(const Vec4f& color);
+	void setBoxColor(const Vec4f& color);
+
+	void draw(const FrameProfiler& profiler, const BoidSystem& boidSystem);
+
+private:
+	Vec2f m_Position;
+	Vec2f m_Padding;
+	Vec4f m_TextColor;
+	Vec4f m_BoxColor;
+
+	bool m_Active;
+
+	static const int m_LineCount = FrameProfiler::StageCount + 6;
+	static const int m_LineLength = 36;
 };
\ No newline at end of file
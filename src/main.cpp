@@ -6,23 +6,40 @@
 #include <ctime>
 #include <cmath>
 #include <iostream>
+#include <thread>
+#include <chrono>
 
 #include "utils/utils.h"
 #include "entities/boid.h"
 #include "interface/interface.h"
+#include "render/renderer.h"
+#include "utils/profiler.h"
 
 int WIDTH = 1080;
 int HEIGHT = 720;
 MouseStats mouseStats;
 
-float old_time;
-float current_time;
+typedef std::chrono::steady_clock Clock;
+
+// the simulation advances in steps of SIMULATION_DT whatever the frame rate, at most MAX_SUBSTEPS per frame;
+// a frame that falls further behind drops the steps it missed, so a hitch slows the fish down instead of making
+// them jump. The boids are drawn between the last two steps by the fraction of a step the accumulator holds.
+const float SIMULATION_DT = 1.0f / 60.0f;
+const int MAX_SUBSTEPS = 4;
+
+Clock::time_point old_time;
 float delta_time;
+float accumulator;
+float interpolation;
 
 BoidSystem boidSystem;
+BoidRenderer boidRenderer;
 
 UserInterface userInterface(&mouseStats);
 
+FrameProfiler frameProfiler;
+ProfilerOverlay profilerOverlay;
+
 void init()
 {
 	srand((unsigned int)time(nullptr));
@@ -43,14 +60,20 @@ void init()
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
 	// models
-	BoidGroup::initModels();
+	BoidRenderer::initModels();
 	UserInterface::initModels();
 
+	if (!boidRenderer.init())
+	{
+		std::cout << "instanced drawing is not supported, drawing boids one by one\n";
+	}
+
 	boidSystem.setBoidBoundary(Boundary2f(0.0f, 0.0f, static_cast<float>(WIDTH), static_cast<float>(HEIGHT)));
 	boidSystem.setBoidBoundaryRepel(Vec2f(15.0f, 15.0f));
+	boidSystem.setThreadCount(std::thread::hardware_concurrency());
 
 	BoidGroup* boidGroup;
-	boidGroup = &boidSystem.addGroup(50);
+	boidGroup = boidSystem.addGroup(50);
 	boidGroup->setBoidSize(Vec2f(15.0f, 5.0f));
 	boidGroup->setBoidFriendliness(0.0f);
 	boidGroup->setBoidViewDistance(60.0f);
@@ -58,7 +81,7 @@ void init()
 	boidGroup->setBoidMaxSpeed(100.0f);
 	boidGroup->setBoidColor(Vec4f(0.0f, 1.0f, 0.0f));
 
-	boidGroup = &boidSystem.addGroup(300);
+	boidGroup = boidSystem.addGroup(300);
 	boidGroup->setBoidSize(Vec2f(15.0f, 5.0f));
 	boidGroup->setBoidFriendliness(0.1f);
 	boidGroup->setBoidViewDistance(60.0f);
@@ -66,7 +89,7 @@ void init()
 	boidGroup->setBoidMaxSpeed(100.0f);
 	boidGroup->setBoidColor(Vec4f(0.0f, 0.0f, 1.0f));
 
-	boidGroup = &boidSystem.addGroup(300);
+	boidGroup = boidSystem.addGroup(300);
 	boidGroup->setBoidSize(Vec2f(15.0f, 5.0f));
 	boidGroup->setBoidFriendliness(0.1f);
 	boidGroup->setBoidViewDistance(60.0f);
@@ -74,6 +97,8 @@ void init()
 	boidGroup->setBoidMaxSpeed(100.0f);
 	boidGroup->setBoidColor(Vec4f(1.0f, 0.0f, 0.0f));
 
+	profilerOverlay.setPosition(Vec2f(WIDTH - profilerOverlay.getSize().x - 10.0f, 10.0f));
+
 	//UI
 	userInterface.setPosition(Vec2f(10.0f, 10.0f));
 	userInterface.setPadding(Vec2f(10.0f, 10.0f));
@@ -219,7 +244,9 @@ void init()
 
 	////////////////////////////////////////////////////
 	
-	old_time = glutGet(GLUT_ELAPSED_TIME) / 1000.0f;
+	old_time = Clock::now();
+	accumulator = 0.0f;
+	interpolation = 1.0f;
 }
 
 
@@ -227,23 +254,48 @@ void draw()
 {
 	glClear(GL_COLOR_BUFFER_BIT);
 
-	boidSystem.draw();
+	frameProfiler.begin(FrameProfiler::BoidSystemDraw);
+	boidRenderer.draw(boidSystem, interpolation);
+	frameProfiler.end(FrameProfiler::BoidSystemDraw);
 
+	frameProfiler.begin(FrameProfiler::UserInterfaceDraw);
 	userInterface.draw();
+	profilerOverlay.draw(frameProfiler, boidSystem);
+	frameProfiler.end(FrameProfiler::UserInterfaceDraw);
 
+	frameProfiler.begin(FrameProfiler::SwapBuffers);
 	glutSwapBuffers();
+	frameProfiler.end(FrameProfiler::SwapBuffers);
+
+	frameProfiler.endFrame();
 }
 
 void idle()
 {
-	current_time = glutGet(GLUT_ELAPSED_TIME) / 1000.0f;
-	delta_time = current_time - old_time;
+	Clock::time_point current_time = Clock::now();
+	delta_time = std::chrono::duration<float>(current_time - old_time).count();
 	old_time = current_time;
 
-	//printf("fps: %.2f\n", 1.0f / delta_time);
+	frameProfiler.begin(FrameProfiler::UserInterfaceUpdate);
 	userInterface.update();
+	frameProfiler.end(FrameProfiler::UserInterfaceUpdate);
+
+	accumulator += delta_time;
 
-	boidSystem.update(delta_time);
+	for (int i = 0; i < MAX_SUBSTEPS && accumulator >= SIMULATION_DT; i++)
+	{
+		boidSystem.update(SIMULATION_DT);
+		accumulator -= SIMULATION_DT;
+
+		const UpdateStats& stats = boidSystem.getUpdateStats();
+		frameProfiler.add(FrameProfiler::NeighborSearch, stats.neighborSeconds);
+		frameProfiler.add(FrameProfiler::Steering, stats.steeringSeconds);
+		frameProfiler.add(FrameProfiler::Integration, stats.integrationSeconds);
+	}
+
+	// whole steps a slow frame could not catch up with are dropped
+	accumulator = std::fmod(accumulator, SIMULATION_DT);
+	interpolation = accumulator / SIMULATION_DT;
 
 	glutPostRedisplay();
 }
@@ -257,7 +309,19 @@ void click_callback(int button, int state, int x, int y)
 
 void keyboard_callback(unsigned char key, int x, int y)
 {
+	switch (key)
+	{
+	case 'i':
+		boidRenderer.setInstanced(!boidRenderer.isInstanced());
+		return;
 
+	case 'p':
+		profilerOverlay.setActive(!profilerOverlay.isActive());
+		return;
+
+	default:
+		return;
+	}
 }
 
 void mouse_position_callback(int x, int y)
@@ -276,7 +340,8 @@ void resize_callback(int width, int height)
 	glOrtho(0.0, WIDTH, HEIGHT, 0.0, -1.0, 1.0);
 
 	boidSystem.setBoidBoundary(Boundary2f(Vec2f(0.0f, 0.0f), Vec2f(static_cast<float>(width), static_cast<float>(height))));
-	
+	profilerOverlay.setPosition(Vec2f(WIDTH - profilerOverlay.getSize().x - 10.0f, 10.0f));
+
 }
 
 int main(int argc, char** argv)
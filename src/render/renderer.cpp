@@ -0,0 +1,359 @@
+#include "renderer.h"
+#include <cstddef>
+#include <iostream>
+
+/************************************************************************************************************
+* GL 1.1 is all the Windows headers declare, everything newer is loaded at runtime through GLUT.
+*************************************************************************************************************/
+
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+#ifndef GL_ARRAY_BUFFER
+#define GL_ARRAY_BUFFER 0x8892
+#endif
+
+#ifndef GL_STATIC_DRAW
+#define GL_STATIC_DRAW 0x88E4
+#endif
+
+#ifndef GL_STREAM_DRAW
+#define GL_STREAM_DRAW 0x88E0
+#endif
+
+#ifndef GL_FRAGMENT_SHADER
+#define GL_FRAGMENT_SHADER 0x8B30
+#endif
+
+#ifndef GL_VERTEX_SHADER
+#define GL_VERTEX_SHADER 0x8B31
+#endif
+
+#ifndef GL_COMPILE_STATUS
+#define GL_COMPILE_STATUS 0x8B81
+#endif
+
+#ifndef GL_LINK_STATUS
+#define GL_LINK_STATUS 0x8B82
+#endif
+
+typedef char GLcharType;
+typedef ptrdiff_t GLsizeiptrType;
+
+struct GLFunctions
+{
+	GLuint (APIENTRY* createShader)(GLenum type);
+	void (APIENTRY* shaderSource)(GLuint shader, GLsizei count, const GLcharType* const* string, const GLint* length);
+	void (APIENTRY* compileShader)(GLuint shader);
+	void (APIENTRY* getShaderiv)(GLuint shader, GLenum pname, GLint* params);
+	void (APIENTRY* getShaderInfoLog)(GLuint shader, GLsizei bufSize, GLsizei* length, GLcharType* infoLog);
+	void (APIENTRY* deleteShader)(GLuint shader);
+	GLuint (APIENTRY* createProgram)();
+	void (APIENTRY* attachShader)(GLuint program, GLuint shader);
+	void (APIENTRY* bindAttribLocation)(GLuint program, GLuint index, const GLcharType* name);
+	void (APIENTRY* linkProgram)(GLuint program);
+	void (APIENTRY* getProgramiv)(GLuint program, GLenum pname, GLint* params);
+	void (APIENTRY* useProgram)(GLuint program);
+	GLint (APIENTRY* getUniformLocation)(GLuint program, const GLcharType* name);
+	void (APIENTRY* uniform2f)(GLint location, GLfloat v0, GLfloat v1);
+	void (APIENTRY* uniform4f)(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3);
+	void (APIENTRY* genBuffers)(GLsizei n, GLuint* buffers);
+	void (APIENTRY* bindBuffer)(GLenum target, GLuint buffer);
+	void (APIENTRY* bufferData)(GLenum target, GLsizeiptrType size, const void* data, GLenum usage);
+	void (APIENTRY* vertexAttribPointer)(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer);
+	void (APIENTRY* enableVertexAttribArray)(GLuint index);
+	void (APIENTRY* disableVertexAttribArray)(GLuint index);
+	void (APIENTRY* vertexAttribDivisor)(GLuint index, GLuint divisor);
+	void (APIENTRY* drawArraysInstanced)(GLenum mode, GLint first, GLsizei count, GLsizei instancecount);
+};
+
+static GLFunctions gl;
+
+template <typename T>
+static bool loadFunction(T& function, const char* name, const char* fallbackName = nullptr)
+{
+	function = reinterpret_cast<T>(glutGetProcAddress(name));
+
+	if (!function && fallbackName)
+	{
+		function = reinterpret_cast<T>(glutGetProcAddress(fallbackName));
+	}
+
+	return function != nullptr;
+}
+
+static bool loadFunctions()
+{
+	bool loaded = true;
+
+	loaded &= loadFunction(gl.createShader, "glCreateShader");
+	loaded &= loadFunction(gl.shaderSource, "glShaderSource");
+	loaded &= loadFunction(gl.compileShader, "glCompileShader");
+	loaded &= loadFunction(gl.getShaderiv, "glGetShaderiv");
+	loaded &= loadFunction(gl.getShaderInfoLog, "glGetShaderInfoLog");
+	loaded &= loadFunction(gl.deleteShader, "glDeleteShader");
+	loaded &= loadFunction(gl.createProgram, "glCreateProgram");
+	loaded &= loadFunction(gl.attachShader, "glAttachShader");
+	loaded &= loadFunction(gl.bindAttribLocation, "glBindAttribLocation");
+	loaded &= loadFunction(gl.linkProgram, "glLinkProgram");
+	loaded &= loadFunction(gl.getProgramiv, "glGetProgramiv");
+	loaded &= loadFunction(gl.useProgram, "glUseProgram");
+	loaded &= loadFunction(gl.getUniformLocation, "glGetUniformLocation");
+	loaded &= loadFunction(gl.uniform2f, "glUniform2f");
+	loaded &= loadFunction(gl.uniform4f, "glUniform4f");
+	loaded &= loadFunction(gl.genBuffers, "glGenBuffers");
+	loaded &= loadFunction(gl.bindBuffer, "glBindBuffer");
+	loaded &= loadFunction(gl.bufferData, "glBufferData");
+	loaded &= loadFunction(gl.vertexAttribPointer, "glVertexAttribPointer");
+	loaded &= loadFunction(gl.enableVertexAttribArray, "glEnableVertexAttribArray");
+	loaded &= loadFunction(gl.disableVertexAttribArray, "glDisableVertexAttribArray");
+	loaded &= loadFunction(gl.vertexAttribDivisor, "glVertexAttribDivisor", "glVertexAttribDivisorARB");
+	loaded &= loadFunction(gl.drawArraysInstanced, "glDrawArraysInstanced", "glDrawArraysInstancedARB");
+
+	return loaded;
+}
+
+static const char* vertexShaderSource =
+	"#version 120\n"
+	"attribute vec2 a_Vertex;\n"
+	"attribute vec4 a_Instance;\n"
+	"uniform vec2 u_Size;\n"
+	"void main()\n"
+	"{\n"
+	"	vec2 local = a_Vertex * u_Size;\n"
+	"	vec2 direction = a_Instance.zw;\n"
+	"	vec2 position = a_Instance.xy + vec2(direction.x * local.x - direction.y * local.y,\n"
+	"		direction.y * local.x + direction.x * local.y);\n"
+	"	gl_Position = gl_ModelViewProjectionMatrix * vec4(position, 0.0, 1.0);\n"
+	"}\n";
+
+static const char* fragmentShaderSource =
+	"#version 120\n"
+	"uniform vec4 u_Color;\n"
+	"void main()\n"
+	"{\n"
+	"	gl_FragColor = u_Color;\n"
+	"}\n";
+
+static const GLuint vertexLocation = 0;
+static const GLuint instanceLocation = 1;
+
+static GLuint compileShader(GLenum type, const char* source)
+{
+	GLuint shader = gl.createShader(type);
+	gl.shaderSource(shader, 1, &source, nullptr);
+	gl.compileShader(shader);
+
+	GLint status = 0;
+	gl.getShaderiv(shader, GL_COMPILE_STATUS, &status);
+
+	if (!status)
+	{
+		char log[512];
+		gl.getShaderInfoLog(shader, sizeof(log), nullptr, log);
+		std::cerr << "boid shader: " << log << std::endl;
+
+		gl.deleteShader(shader);
+		return 0;
+	}
+
+	return shader;
+}
+
+GLuint BoidRenderer::m_ModelList = 0;
+
+BoidRenderer::BoidRenderer()
+{
+	m_Supported = false;
+	m_Instanced = false;
+
+	m_Program = 0;
+	m_ModelBuffer = 0;
+	m_InstanceBuffer = 0;
+	m_SizeLocation = -1;
+	m_ColorLocation = -1;
+}
+
+bool BoidRenderer::init()
+{
+	m_Supported = false;
+	m_Instanced = false;
+
+	if (!loadFunctions())
+	{
+		return false;
+	}
+
+	GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexShaderSource);
+	GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
+
+	if (!vertexShader || !fragmentShader)
+	{
+		return false;
+	}
+
+	m_Program = gl.createProgram();
+	gl.attachShader(m_Program, vertexShader);
+	gl.attachShader(m_Program, fragmentShader);
+	gl.bindAttribLocation(m_Program, vertexLocation, "a_Vertex");
+	gl.bindAttribLocation(m_Program, instanceLocation, "a_Instance");
+	gl.linkProgram(m_Program);
+
+	gl.deleteShader(vertexShader);
+	gl.deleteShader(fragmentShader);
+
+	GLint status = 0;
+	gl.getProgramiv(m_Program, GL_LINK_STATUS, &status);
+
+	if (!status)
+	{
+		return false;
+	}
+
+	m_SizeLocation = gl.getUniformLocation(m_Program, "u_Size");
+	m_ColorLocation = gl.getUniformLocation(m_Program, "u_Color");
+
+	gl.genBuffers(1, &m_ModelBuffer);
+	gl.bindBuffer(GL_ARRAY_BUFFER, m_ModelBuffer);
+	gl.bufferData(GL_ARRAY_BUFFER, BoidGroup::getModelVertexCount() * sizeof(Vec2f), BoidGroup::getModelVertices(), GL_STATIC_DRAW);
+
+	gl.genBuffers(1, &m_InstanceBuffer);
+	gl.bindBuffer(GL_ARRAY_BUFFER, 0);
+
+	m_Supported = true;
+	m_Instanced = true;
+
+	return true;
+}
+
+bool BoidRenderer::isInstanced() const
+{
+	return m_Instanced;
+}
+
+void BoidRenderer::setInstanced(bool value)
+{
+	m_Instanced = value && m_Supported;
+}
+
+void BoidRenderer::draw(BoidSystem& boidSystem, float interpolation)
+{
+	if (m_Instanced)
+	{
+		drawInstanced(boidSystem, interpolation);
+	}
+	else
+	{
+		drawImmediate(boidSystem, interpolation);
+	}
+}
+
+void BoidRenderer::drawBoid(const Boid& boid, const Vec2f& size, const Vec4f& color)
+{
+	Vec2f position = boid.getPosition();
+
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+
+	glTranslatef(position.x, position.y, 0.0f);
+	glRotatef(boid.getAngle(), 0.0f, 0.0f, -1.0f);
+	glScalef(size.x, size.y, 1.0f);
+	glColorVec4f(color);
+
+	glCallList(m_ModelList);
+
+	glPopMatrix();
+}
+
+void BoidRenderer::setModelList(GLuint modelList)
+{
+	m_ModelList = modelList;
+}
+
+void BoidRenderer::initModels()
+{
+	m_ModelList = glGenLists(1);
+
+	glNewList(m_ModelList, GL_COMPILE);
+
+	glBegin(GL_TRIANGLES);
+	for (size_t i = 0; i < BoidGroup::getModelVertexCount(); i++)
+	{
+		glVertexVec2f(BoidGroup::getModelVertices()[i]);
+	}
+	glEnd();
+	glEndList();
+}
+
+void BoidRenderer::drawInstanced(BoidSystem& boidSystem, float interpolation)
+{
+	boidSystem.prepareInstances(m_Instances, interpolation);
+
+	if (m_Instances.empty())
+	{
+		return;
+	}
+
+	gl.useProgram(m_Program);
+
+	gl.bindBuffer(GL_ARRAY_BUFFER, m_ModelBuffer);
+	gl.enableVertexAttribArray(vertexLocation);
+	gl.vertexAttribPointer(vertexLocation, 2, GL_FLOAT, GL_FALSE, sizeof(Vec2f), nullptr);
+
+	// respecifying the whole store lets the driver orphan last frame's copy instead of stalling on it
+	gl.bindBuffer(GL_ARRAY_BUFFER, m_InstanceBuffer);
+	gl.bufferData(GL_ARRAY_BUFFER, m_Instances.size() * sizeof(BoidInstance), m_Instances.data(), GL_STREAM_DRAW);
+	gl.enableVertexAttribArray(instanceLocation);
+	gl.vertexAttribDivisor(instanceLocation, 1);
+
+	std::vector<BoidGroup>& groups = boidSystem.getGroups();
+	const std::vector<size_t>& offsets = boidSystem.getGroupOffsets();
+	GLsizei vertexCount = static_cast<GLsizei>(BoidGroup::getModelVertexCount());
+
+	for (size_t i = 0; i < groups.size(); i++)
+	{
+		size_t count = groups[i].getLiveCount();
+
+		if (!count)
+		{
+			continue;
+		}
+
+		const Vec2f& size = groups[i].getBoidSize();
+		const Vec4f& color = groups[i].getBoidColor();
+
+		gl.uniform2f(m_SizeLocation, size.x, size.y);
+		gl.uniform4f(m_ColorLocation, color.x, color.y, color.z, color.w);
+		gl.vertexAttribPointer(instanceLocation, 4, GL_FLOAT, GL_FALSE, sizeof(BoidInstance),
+			reinterpret_cast<const void*>(offsets[i] * sizeof(BoidInstance)));
+
+		gl.drawArraysInstanced(GL_TRIANGLES, 0, vertexCount, static_cast<GLsizei>(count));
+	}
+
+	gl.vertexAttribDivisor(instanceLocation, 0);
+	gl.disableVertexAttribArray(instanceLocation);
+	gl.disableVertexAttribArray(vertexLocation);
+	gl.bindBuffer(GL_ARRAY_BUFFER, 0);
+	gl.useProgram(0);
+}
+
+void BoidRenderer::drawImmediate(BoidSystem& boidSystem, float interpolation)
+{
+	boidSystem.prepareInstances(m_Instances, interpolation);
+
+	std::vector<BoidGroup>& groups = boidSystem.getGroups();
+	const std::vector<size_t>& offsets = boidSystem.getGroupOffsets();
+
+	for (size_t i = 0; i < groups.size(); i++)
+	{
+		for (size_t j = offsets[i]; j < offsets[i] + groups[i].getLiveCount(); j++)
+		{
+			Boid boid;
+			boid.setPosition(Vec2f(m_Instances[j].x, m_Instances[j].y));
+			boid.setVelocity(Vec2f(m_Instances[j].directionX, m_Instances[j].directionY));
+
+			drawBoid(boid, groups[i].getBoidSize(), groups[i].getBoidColor());
+		}
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "../utils/utils.h"
+#include "../entities/boid.h"
+#include <vector>
+
+/************************************************************************************************************
+* Draws every boid group with one instanced draw call.
+* Per-instance position and heading are streamed into a single buffer each frame, size and color are
+* uniforms of the group. Needs GL 2.0 shaders plus instanced arrays (core since GL 3.3, also exposed by
+* Mesa llvmpipe); when they are missing the renderer falls back to drawing the boids one by one.
+*************************************************************************************************************/
+class BoidRenderer
+{
+public:
+	BoidRenderer();
+
+	bool init();
+
+	bool isInstanced() const;
+	void setInstanced(bool value);
+
+	// interpolation places the boids between the last two ticks, see BoidSystem::prepareInstances
+	void draw(BoidSystem& boidSystem, float interpolation);
+
+	static void drawBoid(const Boid& boid, const Vec2f& size, const Vec4f& color);
+
+	static void setModelList(GLuint modelList);
+	static void initModels();
+
+private:
+	void drawInstanced(BoidSystem& boidSystem, float interpolation);
+	void drawImmediate(BoidSystem& boidSystem, float interpolation);
+
+private:
+	bool m_Supported;
+	bool m_Instanced;
+
+	GLuint m_Program;
+	GLuint m_ModelBuffer;
+	GLuint m_InstanceBuffer;
+	GLint m_SizeLocation;
+	GLint m_ColorLocation;
+
+	std::vector<BoidInstance> m_Instances;
+
+	static GLuint m_ModelList;
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vector>
+#include <new>
+#include <cstddef>
+
+/************************************************************************************************************
+* Allocator for containers whose storage must start on an aligned address (SIMD loads, cache lines).
+*************************************************************************************************************/
+template <typename T, size_t Alignment>
+struct AlignedAllocator
+{
+	typedef T value_type;
+
+	template <typename U>
+	struct rebind
+	{
+		typedef AlignedAllocator<U, Alignment> other;
+	};
+
+	AlignedAllocator() noexcept
+	{
+	}
+
+	template <typename U>
+	AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept
+	{
+	}
+
+	T* allocate(size_t count)
+	{
+		return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(Alignment)));
+	}
+
+	void deallocate(T* ptr, size_t) noexcept
+	{
+		::operator delete(ptr, std::align_val_t(Alignment));
+	}
+};
+
+template <typename T, typename U, size_t Alignment>
+bool operator==(const AlignedAllocator<T, Alignment>&, const AlignedAllocator<U, Alignment>&)
+{
+	return true;
+}
+
+template <typename T, typename U, size_t Alignment>
+bool operator!=(const AlignedAllocator<T, Alignment>&, const AlignedAllocator<U, Alignment>&)
+{
+	return false;
+}
+
+const size_t SIMD_ALIGNMENT = 64;
+const size_t SIMD_WIDTH = SIMD_ALIGNMENT / sizeof(float);
+
+template <typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T, SIMD_ALIGNMENT>>;
@@ -0,0 +1,110 @@
+#include "cpu.h"
+#include <cstring>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+
+static SimdLevel detectLevel()
+{
+#if defined(_MSC_VER)
+	int info[4];
+
+	__cpuid(info, 0);
+	int maxLeaf = info[0];
+
+	__cpuid(info, 1);
+	bool sse2 = (info[3] & (1 << 26)) != 0;
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+
+	bool avx2 = false;
+	bool avx512 = false;
+	if (maxLeaf >= 7)
+	{
+		__cpuidex(info, 7, 0);
+		avx2 = (info[1] & (1 << 5)) != 0;
+		avx512 = (info[1] & (1 << 16)) != 0;
+	}
+
+	// the registers are only usable if the operating system saves them on a context switch
+	unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+	bool ymm = avx && (xcr0 & 0x6) == 0x6;
+	bool zmm = ymm && (xcr0 & 0xe0) == 0xe0;
+
+	if (avx512 && zmm)
+	{
+		return SimdLevel::AVX512;
+	}
+	if (avx2 && ymm)
+	{
+		return SimdLevel::AVX2;
+	}
+	return sse2 ? SimdLevel::SSE2 : SimdLevel::Scalar;
+#else
+	__builtin_cpu_init();
+
+	// libgcc also checks that the operating system saves the wider registers
+	if (__builtin_cpu_supports("avx512f"))
+	{
+		return SimdLevel::AVX512;
+	}
+	if (__builtin_cpu_supports("avx2"))
+	{
+		return SimdLevel::AVX2;
+	}
+	return __builtin_cpu_supports("sse2") ? SimdLevel::SSE2 : SimdLevel::Scalar;
+#endif
+}
+
+#else
+
+static SimdLevel detectLevel()
+{
+	return SimdLevel::Scalar;
+}
+
+#endif
+
+SimdLevel detectSimdLevel()
+{
+	static const SimdLevel level = detectLevel();
+
+	return level;
+}
+
+const char* simdLevelName(SimdLevel level)
+{
+	switch (level)
+	{
+	case SimdLevel::Scalar:
+		return "scalar";
+	case SimdLevel::SSE2:
+		return "sse2";
+	case SimdLevel::AVX2:
+		return "avx2";
+	case SimdLevel::AVX512:
+		return "avx512";
+	}
+
+	return "";
+}
+
+bool parseSimdLevel(const char* name, SimdLevel& level)
+{
+	const SimdLevel levels[] = { SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::AVX512 };
+
+	for (SimdLevel candidate : levels)
+	{
+		if (std::strcmp(name, simdLevelName(candidate)) == 0)
+		{
+			level = candidate;
+			return true;
+		}
+	}
+
+	return false;
+}
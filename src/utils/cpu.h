@@ -0,0 +1,17 @@
+#pragma once
+
+/************************************************************************************************************
+* Instruction sets the SIMD kernels are written for, in increasing order.
+*************************************************************************************************************/
+enum class SimdLevel
+{
+	Scalar,
+	SSE2,
+	AVX2,
+	AVX512
+};
+
+// the best level the processor and the operating system support, detected on the first call
+SimdLevel detectSimdLevel();
+const char* simdLevelName(SimdLevel level);
+bool parseSimdLevel(const char* name, SimdLevel& level);
@@ -0,0 +1,125 @@
+#include "profiler.h"
+#include <algorithm>
+
+FrameProfiler::FrameProfiler()
+	: FrameProfiler(120)
+{
+}
+
+FrameProfiler::FrameProfiler(size_t frameCount)
+{
+	frameCount = std::max<size_t>(frameCount, 1);
+
+	for (size_t i = 0; i < StageCount; i++)
+	{
+		m_Samples[i].assign(frameCount, 0.0);
+		m_Current[i] = 0.0;
+	}
+	m_FrameSamples.assign(frameCount, 0.0);
+
+	m_Frame = 0;
+	m_FrameCount = 0;
+	m_FrameStart = Clock::now();
+}
+
+void FrameProfiler::begin(Stage stage)
+{
+	m_Start[stage] = Clock::now();
+}
+
+void FrameProfiler::end(Stage stage)
+{
+	add(stage, std::chrono::duration<double>(Clock::now() - m_Start[stage]).count());
+}
+
+void FrameProfiler::add(Stage stage, double seconds)
+{
+	m_Current[stage] += seconds;
+}
+
+void FrameProfiler::endFrame()
+{
+	Clock::time_point now = Clock::now();
+
+	for (size_t i = 0; i < StageCount; i++)
+	{
+		m_Samples[i][m_Frame] = m_Current[i];
+		m_Current[i] = 0.0;
+	}
+	m_FrameSamples[m_Frame] = std::chrono::duration<double>(now - m_FrameStart).count();
+	m_FrameStart = now;
+
+	m_Frame = (m_Frame + 1) % m_FrameSamples.size();
+	m_FrameCount = std::min(m_FrameCount + 1, m_FrameSamples.size());
+}
+
+size_t FrameProfiler::getFrameCount() const
+{
+	return m_FrameCount;
+}
+
+double FrameProfiler::getAverage(Stage stage) const
+{
+	if (!m_FrameCount)
+	{
+		return 0.0;
+	}
+
+	double sum = 0.0;
+	for (size_t i = 0; i < m_FrameCount; i++)
+	{
+		sum += m_Samples[stage][i];
+	}
+
+	return sum / static_cast<double>(m_FrameCount);
+}
+
+double FrameProfiler::getMax(Stage stage) const
+{
+	// the ring is filled from the front, samples past m_FrameCount were never written
+	return m_FrameCount ? *std::max_element(m_Samples[stage].begin(), m_Samples[stage].begin() + m_FrameCount) : 0.0;
+}
+
+double FrameProfiler::getFrameAverage() const
+{
+	if (!m_FrameCount)
+	{
+		return 0.0;
+	}
+
+	double sum = 0.0;
+	for (size_t i = 0; i < m_FrameCount; i++)
+	{
+		sum += m_FrameSamples[i];
+	}
+
+	return sum / static_cast<double>(m_FrameCount);
+}
+
+double FrameProfiler::getFrameMax() const
+{
+	return m_FrameCount ? *std::max_element(m_FrameSamples.begin(), m_FrameSamples.begin() + m_FrameCount) : 0.0;
+}
+
+const char* FrameProfiler::getStageName(Stage stage)
+{
+	switch (stage)
+	{
+	case UserInterfaceUpdate:
+		return "ui update";
+	case NeighborSearch:
+		return "neighbor search";
+	case Steering:
+		return "steering";
+	case Integration:
+		return "integration";
+	case BoidSystemDraw:
+		return "boid draw";
+	case UserInterfaceDraw:
+		return "ui draw";
+	case SwapBuffers:
+		return "swap buffers";
+	default:
+		return "";
+	}
+}
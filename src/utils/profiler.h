@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+#include <chrono>
+
+/************************************************************************************************************
+* Rolling per-stage frame timings: every stage keeps the samples of the last frames in a ring buffer,
+* from which the average and the maximum are read. The frame time is the wall time between endFrame calls.
+*************************************************************************************************************/
+class FrameProfiler
+{
+public:
+	enum Stage
+	{
+		UserInterfaceUpdate,
+		NeighborSearch,
+		Steering,
+		Integration,
+		BoidSystemDraw,
+		UserInterfaceDraw,
+		SwapBuffers,
+		StageCount
+	};
+
+	FrameProfiler();
+	explicit FrameProfiler(size_t frameCount);
+
+	void begin(Stage stage);
+	void end(Stage stage);
+	void add(Stage stage, double seconds);
+
+	void endFrame();
+
+	size_t getFrameCount() const;
+	double getAverage(Stage stage) const;
+	double getMax(Stage stage) const;
+	double getFrameAverage() const;
+	double getFrameMax() const;
+
+	static const char* getStageName(Stage stage);
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	std::vector<double> m_Samples[StageCount];
+	std::vector<double> m_FrameSamples;
+	double m_Current[StageCount];
+	Clock::time_point m_Start[StageCount];
+	Clock::time_point m_FrameStart;
+
+	size_t m_Frame;
+	size_t m_FrameCount;
+};
@@ -0,0 +1,159 @@
+#include "threadpool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool()
+	: ThreadPool(1)
+{
+}
+
+ThreadPool::ThreadPool(size_t threadCount)
+{
+	m_ThreadCount = std::max<size_t>(threadCount, 1);
+
+	m_Task = nullptr;
+	m_Count = 0;
+	m_ChunkSize = m_MinChunkSize;
+	m_Next = 0;
+	m_Busy = 0;
+	m_Generation = 0;
+	m_Stopping = false;
+}
+
+ThreadPool::~ThreadPool()
+{
+	stop();
+}
+
+size_t ThreadPool::getThreadCount() const
+{
+	return m_ThreadCount;
+}
+
+void ThreadPool::setThreadCount(size_t threadCount)
+{
+	threadCount = std::max<size_t>(threadCount, 1);
+
+	if (threadCount == m_ThreadCount)
+	{
+		return;
+	}
+
+	stop();
+	m_ThreadCount = threadCount;
+}
+
+void ThreadPool::run(size_t count, const Task& task)
+{
+	run(count, std::max(m_MinChunkSize, count / (m_ThreadCount * 8)), task);
+}
+
+void ThreadPool::run(size_t count, size_t chunkSize, const Task& task)
+{
+	if (!count)
+	{
+		return;
+	}
+
+	chunkSize = std::max<size_t>(chunkSize, 1);
+
+	if (m_ThreadCount == 1 || count <= chunkSize)
+	{
+		task(0, count, 0);
+		return;
+	}
+
+	if (m_Threads.empty())
+	{
+		start();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		m_Task = &task;
+		m_Count = count;
+		m_ChunkSize = chunkSize;
+		m_Next = 0;
+		m_Busy = m_Threads.size();
+		m_Generation++;
+	}
+	m_WorkReady.notify_all();
+
+	work(0);
+
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_WorkDone.wait(lock, [this] { return m_Busy == 0; });
+	m_Task = nullptr;
+}
+
+void ThreadPool::start()
+{
+	uint64_t generation;
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Stopping = false;
+		generation = m_Generation;
+	}
+
+	for (size_t i = 1; i < m_ThreadCount; i++)
+	{
+		m_Threads.push_back(std::thread(&ThreadPool::workerLoop, this, i, generation));
+	}
+}
+
+void ThreadPool::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Stopping = true;
+	}
+	m_WorkReady.notify_all();
+
+	for (size_t i = 0; i < m_Threads.size(); i++)
+	{
+		m_Threads[i].join();
+	}
+
+	m_Threads.clear();
+}
+
+void ThreadPool::workerLoop(size_t worker, uint64_t generation)
+{
+	for (;;)
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_WorkReady.wait(lock, [this, generation] { return m_Stopping || m_Generation != generation; });
+
+		if (m_Stopping)
+		{
+			return;
+		}
+
+		generation = m_Generation;
+		lock.unlock();
+
+		work(worker);
+
+		lock.lock();
+		if (--m_Busy == 0)
+		{
+			m_WorkDone.notify_one();
+		}
+	}
+}
+
+void ThreadPool::work(size_t worker)
+{
+	for (;;)
+	{
+		size_t begin = m_Next.fetch_add(m_ChunkSize);
+
+		if (begin >= m_Count)
+		{
+			return;
+		}
+
+		(*m_Task)(begin, std::min(begin + m_ChunkSize, m_Count), worker);
+	}
+}
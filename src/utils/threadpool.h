@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <cstdint>
+
+/************************************************************************************************************
+* Fixed set of worker threads that split an index range [0, count) into chunks.
+* The calling thread works as worker 0, so a pool of n threads starts n - 1 background threads.
+* The threads are started on the first run, not in the constructor.
+* Unless a chunk size is given, chunks hold at least m_MinChunkSize indices.
+*************************************************************************************************************/
+class ThreadPool
+{
+public:
+	typedef std::function<void(size_t begin, size_t end, size_t worker)> Task;
+
+	ThreadPool();
+	explicit ThreadPool(size_t threadCount);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	size_t getThreadCount() const;
+
+	void setThreadCount(size_t threadCount);
+
+	void run(size_t count, const Task& task);
+	void run(size_t count, size_t chunkSize, const Task& task);
+
+private:
+	void start();
+	void stop();
+	// generation is the one the pool was at when the worker started, the worker waits for the next one
+	void workerLoop(size_t worker, uint64_t generation);
+	void work(size_t worker);
+
+private:
+	std::vector<std::thread> m_Threads;
+	size_t m_ThreadCount;
+
+	std::mutex m_Mutex;
+	std::condition_variable m_WorkReady;
+	std::condition_variable m_WorkDone;
+
+	const Task* m_Task;
+	size_t m_Count;
+	size_t m_ChunkSize;
+	std::atomic<size_t> m_Next;
+	size_t m_Busy;
+	uint64_t m_Generation;
+	bool m_Stopping;
+
+	static constexpr size_t m_MinChunkSize = 64;
+};
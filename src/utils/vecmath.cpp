@@ -0,0 +1,159 @@
+#include "vecmath.h"
+
+#include <algorithm>
+#include <ostream>
+#include <cmath>
+#include <random>
+
+/************************************************************************************************************
+* Implementarea functiilor/metodelor care opereaza cu vectori.
+* Sunt implementati si operatori pentru usurinta.
+*************************************************************************************************************/
+
+/************************************************************************************************************
+*													Vec4f
+*************************************************************************************************************/
+std::ostream& operator<<(std::ostream& out, const Vec4f& v)
+{
+	out << "(" << v.x << ", " << v.y << ", " << v.z << ")";
+
+	return out;
+}
+
+/************************************************************************************************************
+*													Vec2f
+*************************************************************************************************************/
+std::ostream& operator<<(std::ostream& out, const Vec2f& v)
+{
+	out << "(" << v.x << ", " << v.y  << ")";
+
+	return out;
+}
+
+/************************************************************************************************************
+*													Boundary2f
+*************************************************************************************************************/
+
+Boundary2f::Boundary2f()
+{
+}
+
+Boundary2f::Boundary2f(const Vec2f& min, const Vec2f& max)
+{
+	this->min = min;
+	this->max = max;
+}
+
+Boundary2f::Boundary2f(float minx, float miny, float maxx, float maxy)
+{
+	min.x = minx;
+	min.y = miny;
+	max.x = maxx;
+	max.y = maxy;
+}
+
+Vec2f Boundary2f::getSize() const
+{
+	return Vec2f(std::fabs(max.x - min.x), std::fabs(max.y - min.y));
+}
+
+bool Boundary2f::contains(const Vec2f& point) const
+{
+	Vec2f minaux = min;
+	Vec2f maxaux = max;
+
+	if (minaux.x > maxaux.x)
+	{
+		minaux.x = max.x;
+		maxaux.x = min.x;
+	}
+
+	if (minaux.y > maxaux.y)
+	{
+		minaux.y = max.y;
+		maxaux.y = min.y;
+	}
+
+	return ((minaux.x <= point.x) && (maxaux.x >= point.x) && (minaux.y <= point.y) && (maxaux.y >= point.y));
+}
+
+bool Boundary2f::contains(float x, float y) const
+{
+	return contains(Vec2f(x, y));
+}
+
+void Boundary2f::extend(const Vec2f& point)
+{
+	min.x = std::min(min.x, point.x);
+	min.y = std::min(min.y, point.y);
+	max.x = std::max(max.x, point.x);
+	max.y = std::max(max.y, point.y);
+}
+
+void Boundary2f::extend(const Boundary2f& bounds)
+{
+	min.x = std::min(min.x, bounds.min.x);
+	min.y = std::min(min.y, bounds.min.y);
+	max.x = std::max(max.x, bounds.max.x);
+	max.y = std::max(max.y, bounds.max.y);
+}
+
+/************************************************************************************************************
+*													CircleBoundary2f
+*************************************************************************************************************/
+
+CircleBoundary2f::CircleBoundary2f()
+{
+	radius = 1.0f;
+}
+
+CircleBoundary2f::CircleBoundary2f(const Vec2f& position, float radius)
+{
+	this->position = position;
+	this->radius = radius;
+}
+
+CircleBoundary2f::CircleBoundary2f(float x, float y, float radius)
+{
+	this->position = Vec2f(x, y);
+	this->radius = radius;
+}
+
+bool CircleBoundary2f::contains(const Vec2f& point)
+{
+	return (Vec2f::length2(point - position) <= radius * radius);
+}
+
+bool CircleBoundary2f::contains(float x, float y)
+{
+	return contains(Vec2f(x, y));
+}
+
+/************************************************************************************************************
+* Implementarea altor functii.
+*************************************************************************************************************/
+
+int rand_int(int min, int max)
+{
+	return min + std::rand() % (max - min + 1);
+}
+
+float rand_float(float min, float max)
+{
+	return min + static_cast<float>(std::rand() % 1024) / 1023.f * (max - min);
+}
+
+Vec4f rand_color()
+{
+	return Vec4f(rand_float(), rand_float(), rand_float());
+}
+
+Vec2f rand_direction()
+{
+	return Vec2f::normalize(Vec2f(rand_float(-1.0f, 1.0f), rand_float(-1.0f, 1.0f)));
+}
+
+Vec4f color256to1(const Vec4f& color)
+{
+	return color / 255.0f;
+}
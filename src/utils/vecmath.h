@@ -0,0 +1,352 @@
+#pragma once
+
+#include <string>
+#include <sstream>
+#include <cmath>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979
+#endif
+
+/************************************************************************************************************
+* Vector cu 4 componente de tip float.
+* Metodele/functiile care lucreaza cu acet tip de vector iau in considerare doar primele trei componente.
+*************************************************************************************************************/
+struct Vec2f;
+
+struct Vec4f
+{
+	float x;
+	float y;
+	float z;
+	float w;
+
+	constexpr Vec4f(float x = 0.0f, float y = 0.0f, float z = 0.0f, float w = 1.0f) : x(x), y(y), z(z), w(w) {}
+	constexpr Vec4f(const Vec2f& v2, float z = 0.0f, float w = 1.0f);
+
+	// like the binary operators they only touch the first three components, w is left as it is
+	constexpr Vec4f& operator+=(const Vec4f& rhs);
+	constexpr Vec4f& operator-=(const Vec4f& rhs);
+	constexpr Vec4f& operator*=(float s);
+	constexpr Vec4f& operator/=(float s);
+
+	static constexpr float dot(const Vec4f& a, const Vec4f& b);
+	static constexpr Vec4f cross(const Vec4f& a, const Vec4f& b);
+	static float length(const Vec4f& v);
+	static constexpr float length2(const Vec4f& v);
+	static Vec4f normalize(const Vec4f& v);
+	static constexpr Vec4f reflect(const Vec4f& v, const Vec4f& n);
+};
+
+constexpr Vec4f operator*(const Vec4f& v, float s);
+constexpr Vec4f operator*(float s, const Vec4f& v);
+constexpr Vec4f operator/(const Vec4f& v, float s);
+constexpr Vec4f operator+(const Vec4f& lhs, const Vec4f& rhs);
+constexpr Vec4f operator-(const Vec4f& lhs, const Vec4f& rhs);
+std::ostream& operator<<(std::ostream& out, const Vec4f& v);
+
+struct Vec2f
+{
+	float x;
+	float y;
+
+	constexpr Vec2f(float x = 0.0f, float y = 0.0f) : x(x), y(y) {}
+	constexpr Vec2f(const Vec4f& v4) : x(v4.x), y(v4.y) {}
+
+	constexpr Vec2f& operator+=(const Vec2f& rhs);
+	constexpr Vec2f& operator-=(const Vec2f& rhs);
+	constexpr Vec2f& operator*=(float s);
+	constexpr Vec2f& operator/=(float s);
+
+	static constexpr float dot(const Vec2f& a, const Vec2f& b);
+	static constexpr float det(const Vec2f& a, const Vec2f& b);
+	static constexpr Vec4f cross(const Vec2f& a, const Vec2f& b);
+	static float length(const Vec2f& v);
+	static constexpr float length2(const Vec2f& v);
+	static Vec2f normalize(const Vec2f& v);
+	static constexpr Vec2f reflect(const Vec2f& v, const Vec2f& n);
+	static float angleRad(const Vec2f& a, const Vec2f& b);
+	static float angleDeg(const Vec2f& a, const Vec2f& b);
+};
+
+constexpr Vec2f operator*(const Vec2f& v, float s);
+constexpr Vec2f operator*(float s, const Vec2f& v);
+constexpr Vec2f operator/(const Vec2f& v, float s);
+constexpr Vec2f operator+(const Vec2f& lhs, const Vec2f& rhs);
+constexpr Vec2f operator-(const Vec2f& lhs, const Vec2f& rhs);
+std::ostream& operator<<(std::ostream& out, const Vec2f& v);
+
+struct Boundary2f
+{
+	Vec2f min;
+	Vec2f max;
+
+	Boundary2f();
+	Boundary2f(const Vec2f& min, const Vec2f& max);
+	Boundary2f(float minx, float miny, float maxx, float maxy);
+	
+	Vec2f getSize() const;
+
+	bool contains(const Vec2f& point) const;
+	bool contains(float x, float y) const;
+
+	// grows the boundary to include the point or the other boundary, min must not be greater than max
+	void extend(const Vec2f& point);
+	void extend(const Boundary2f& bounds);
+};
+
+struct CircleBoundary2f
+{
+	Vec2f position;
+	float radius;
+
+	CircleBoundary2f();
+	CircleBoundary2f(const Vec2f& position, float radius);
+	CircleBoundary2f(float x, float y, float radius);
+
+	bool contains(const Vec2f& point);
+	bool contains(float x, float y);
+};
+
+/************************************************************************************************************
+* The vectors are defined here so that the steering and integration loops can inline every operation.
+*************************************************************************************************************/
+
+/************************************************************************************************************
+*													Vec4f
+*************************************************************************************************************/
+constexpr Vec4f::Vec4f(const Vec2f& v2, float z, float w) : x(v2.x), y(v2.y), z(z), w(w)
+{
+}
+
+constexpr Vec4f& Vec4f::operator+=(const Vec4f& rhs)
+{
+	x += rhs.x;
+	y += rhs.y;
+	z += rhs.z;
+
+	return *this;
+}
+
+constexpr Vec4f& Vec4f::operator-=(const Vec4f& rhs)
+{
+	x -= rhs.x;
+	y -= rhs.y;
+	z -= rhs.z;
+
+	return *this;
+}
+
+constexpr Vec4f& Vec4f::operator*=(float s)
+{
+	x *= s;
+	y *= s;
+	z *= s;
+
+	return *this;
+}
+
+constexpr Vec4f& Vec4f::operator/=(float s)
+{
+	x /= s;
+	y /= s;
+	z /= s;
+
+	return *this;
+}
+
+constexpr Vec4f operator*(const Vec4f& v, float s)
+{
+	return Vec4f(v.x * s, v.y * s, v.z * s);
+}
+
+constexpr Vec4f operator*(float s, const Vec4f& v)
+{
+	return v * s;
+}
+
+constexpr Vec4f operator/(const Vec4f& v, float s)
+{
+	return Vec4f(v.x / s, v.y / s, v.z / s);
+}
+
+constexpr Vec4f operator+(const Vec4f& lhs, const Vec4f& rhs)
+{
+	return Vec4f(lhs.x + rhs.x, lhs.y + rhs.y, lhs.z + rhs.z);
+}
+
+constexpr Vec4f operator-(const Vec4f& lhs, const Vec4f& rhs)
+{
+	return Vec4f(lhs.x - rhs.x, lhs.y - rhs.y, lhs.z - rhs.z);
+}
+
+constexpr float Vec4f::dot(const Vec4f& a, const Vec4f& b)
+{
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+constexpr Vec4f Vec4f::cross(const Vec4f& a, const Vec4f& b)
+{
+	/*
+	*  |  1   1   1  |
+	*  | a.x a.y a.z |
+	*  | b.x b.y b.z |
+	*/
+
+	return Vec4f(
+			a.y * b.z - a.z * b.y,
+			a.z * b.x - a.x * b.z,
+			a.x * b.y - a.y * b.x);
+}
+
+inline float Vec4f::length(const Vec4f& v)
+{
+	return sqrtf(Vec4f::dot(v, v));
+}
+
+constexpr float Vec4f::length2(const Vec4f& v)
+{
+	return Vec4f::dot(v, v);
+}
+
+inline Vec4f Vec4f::normalize(const Vec4f& v)
+{
+	return v / Vec4f::length(v);
+}
+
+constexpr Vec4f Vec4f::reflect(const Vec4f& v, const Vec4f& n)
+{
+	return v - 2.0f * Vec4f::dot(v, n) * n;
+}
+
+/************************************************************************************************************
+*													Vec2f
+*************************************************************************************************************/
+constexpr Vec2f& Vec2f::operator+=(const Vec2f& rhs)
+{
+	x += rhs.x;
+	y += rhs.y;
+
+	return *this;
+}
+
+constexpr Vec2f& Vec2f::operator-=(const Vec2f& rhs)
+{
+	x -= rhs.x;
+	y -= rhs.y;
+
+	return *this;
+}
+
+constexpr Vec2f& Vec2f::operator*=(float s)
+{
+	x *= s;
+	y *= s;
+
+	return *this;
+}
+
+constexpr Vec2f& Vec2f::operator/=(float s)
+{
+	x /= s;
+	y /= s;
+
+	return *this;
+}
+
+constexpr Vec2f operator*(const Vec2f& v, float s)
+{
+	return Vec2f(v.x * s, v.y * s);
+}
+
+constexpr Vec2f operator*(float s, const Vec2f& v)
+{
+	return v * s;
+}
+
+constexpr Vec2f operator/(const Vec2f& v, float s)
+{
+	return Vec2f(v.x / s, v.y / s);
+}
+
+constexpr Vec2f operator+(const Vec2f& lhs, const Vec2f& rhs)
+{
+	return Vec2f(lhs.x + rhs.x, lhs.y + rhs.y);
+}
+
+constexpr Vec2f operator-(const Vec2f& lhs, const Vec2f& rhs)
+{
+	return Vec2f(lhs.x - rhs.x, lhs.y - rhs.y);
+}
+
+constexpr float Vec2f::dot(const Vec2f& a, const Vec2f& b)
+{
+	return a.x * b.x + a.y * b.y;
+}
+
+constexpr float Vec2f::det(const Vec2f& a, const Vec2f& b)
+{
+	return a.x * b.y - a.y * b.x;
+}
+
+constexpr Vec4f Vec2f::cross(const Vec2f& a, const Vec2f& b)
+{
+	/*
+	*  |  1   1   1  |
+	*  | a.x a.y a.z |
+	*  | b.x b.y b.z |
+	*/
+
+	return Vec4f(0.0f, 0.0f, a.x * b.y - a.y * b.x);
+}
+
+inline float Vec2f::length(const Vec2f& v)
+{
+	return sqrtf(Vec2f::dot(v, v));
+}
+
+constexpr float Vec2f::length2(const Vec2f& v)
+{
+	return Vec2f::dot(v, v);
+}
+
+inline Vec2f Vec2f::normalize(const Vec2f& v)
+{
+	return v / Vec2f::length(v);
+}
+
+constexpr Vec2f Vec2f::reflect(const Vec2f& v, const Vec2f& n)
+{
+	return v - 2.0f * Vec2f::dot(v, n) * n;
+}
+
+inline float Vec2f::angleRad(const Vec2f& a, const Vec2f& b)
+{
+	return atan2f(Vec2f::det(a, b), Vec2f::dot(a, b));
+}
+
+inline float Vec2f::angleDeg(const Vec2f& a, const Vec2f& b)
+{
+	return Vec2f::angleRad(a, b) * (180.0f / (float)M_PI);
+}
+
+/************************************************************************************************************
+* Alte functii utile.
+*************************************************************************************************************/
+
+int rand_int(int min, int max);
+float rand_float(float min = 0.0f, float max = 1.0f);
+Vec4f rand_color();
+Vec2f rand_direction();
+
+Vec4f color256to1(const Vec4f& color);
+
+template <typename T>
+std::string to_stringn(const T value, std::streamsize precision)
+{
+	std::ostringstream out;
+	out.precision(precision);
+	out << std::fixed << value;
+
+	return out.str();
+}
\ No newline at end of file